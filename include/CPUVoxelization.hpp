@@ -0,0 +1,113 @@
+#ifndef CPUVOXELIZATION_HPP_INCLUDED
+#define CPUVOXELIZATION_HPP_INCLUDED
+
+
+#include "glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+/**@brief CPU voxelization backend, usable without any OpenGL context.
+ *
+ * A voxel is set if its box overlaps a triangle (separating axis theorem,
+ * 13 axes), so the result is slightly thicker than the GPU rasterization one.
+ * The grid has the layout documented in Voxelizer.hpp.
+ *
+ * The inner loop tests a whole column of 32 Z-voxels at a time and directly produces
+ * the occupancy word. It has SSE4.2, AVX2 and AVX-512 variants (4, 8 and 16 voxels per instruction),
+ * picked at runtime from CPUID, and a scalar fallback. All variants give the exact same words.
+ *
+ * voxelizeSolid fills the inside of closed meshes instead, by parity of the surface crossings along Z.
+ */
+namespace CPUVoxelization
+{
+    /* Instruction sets of the column kernels. Auto picks the best one supported by the CPU. */
+    enum class ISA {Auto, Scalar, SSE42, AVX2, AVX512};
+
+    /* Six: every voxel overlapped by the triangle (6-separating surface).
+     * TwentySix: the plane test only keeps the voxels crossed by the plane along
+     * its dominant axis, giving a thinner 26-separating surface. */
+    enum class Separability {Six, TwentySix};
+
+    /* Triangle prepared for overlap tests against unit voxel boxes.
+     * The triangle is expressed in voxel units: voxel (i,j,k) is the box [i,i+1]x[j,j+1]x[k,k+1].
+     * A box of center c overlaps the triangle if, for each axis a, lo <= dot(a,c) <= hi. */
+    struct TriangleBoxTest
+    {
+        glm::vec3 axes[13];
+        float lo[13];
+        float hi[13];
+
+        glm::vec3 minCoords;
+        glm::vec3 maxCoords;
+
+        TriangleBoxTest(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2,
+                        Separability separability=Separability::Six);
+
+        bool overlaps(unsigned int iX, unsigned int iY, unsigned int iZ) const;
+    };
+
+    /* Returns the occupancy word of the column (iX,iY) for the slab containing firstZ.
+     * Only the voxels from firstZ to lastZ (same slab) are tested, the other bits are 0. */
+    typedef uint32_t (*ColumnKernel)(TriangleBoxTest const& test,
+                                     unsigned int iX, unsigned int iY,
+                                     unsigned int firstZ, unsigned int lastZ);
+
+    /* The best instruction set supported by both the CPU and the compiler. */
+    ISA detectISA();
+
+    bool isSupported(ISA isa);
+
+    const char* isaName(ISA isa);
+
+    /* @return nullptr if the instruction set isn't supported */
+    ColumnKernel columnKernel(ISA isa);
+
+    /* Sets the bits of every voxel overlapped by a triangle (see Separability).
+     * The grid holds the nbVoxels voxels from firstVoxel (Z a multiple of 32) of the grid whose corner is minCorner,
+     * so that a tile gives the exact words of the whole grid computation.
+     * It must already be allocated (nbVoxels.x * nbVoxels.y * nbVoxels.z / 32 words).
+     * The work is split in bricks (32 Z-slices x 32 rows) spread over nbThreads threads,
+     * 0 meaning one per hardware thread. Each brick owns its words so no synchronization is needed. */
+    void voxelize(std::vector<glm::vec3> const& vertices,
+                  std::vector<glm::ivec3> const& triangles,
+                  glm::vec3 const& minCorner,
+                  float voxelSize,
+                  glm::uvec3 const& nbVoxels,
+                  glm::uvec3 const& firstVoxel,
+                  std::vector<uint32_t>& grid,
+                  Separability separability=Separability::Six,
+                  unsigned int nbThreads=0,
+                  ISA isa=ISA::Auto);
+
+    /* Sets the bits of every voxel whose center is inside the mesh, which must be closed.
+     * Each triangle flips, in the columns whose center it covers, the first voxel above its crossing point,
+     * with a tie rule on the edges so that the columns on a shared edge are counted once.
+     * prefixXorSweep then turns the flips into inside/outside states. The grid must be allocated and empty.
+     * Like voxelize, it may only hold the voxels from firstVoxel, the crossings below it flipping its first layer. */
+    void voxelizeSolid(std::vector<glm::vec3> const& vertices,
+                       std::vector<glm::ivec3> const& triangles,
+                       glm::vec3 const& minCorner,
+                       float voxelSize,
+                       glm::uvec3 const& nbVoxels,
+                       glm::uvec3 const& firstVoxel,
+                       std::vector<uint32_t>& grid,
+                       unsigned int nbThreads=0);
+
+    /* Replaces each bit by the XOR of itself and all the bits below it in its column (Z axis),
+     * within the word then across the successive slabs. */
+    void prefixXorSweep(glm::uvec3 const& nbVoxels, std::vector<uint32_t>& grid);
+
+    /* Same, for one slab of nbWords words at a time, the slabs being given in order.
+     * carries holds the state of each column at the top of the previous slab (0 or all ones, 0 initially). */
+    void prefixXorSweepSlab(uint32_t* slab, uint32_t* carries, std::size_t nbWords);
+
+    /* Next level of an occupancy pyramid: halves the dimensions (rounded up), a voxel being set if one of its
+     * 2x2x2 children is. Both grids have the layout of Voxelizer.hpp, the Z dimension being rounded up to 32 voxels
+     * in the words (bits beyond it are 0). The Z pairs are merged 32 at a time with bit operations on whole words. */
+    void orReduce(glm::uvec3 const& nbVoxels, std::vector<uint32_t> const& grid,
+                  glm::uvec3& reducedSize, std::vector<uint32_t>& reduced);
+}
+
+#endif // CPUVOXELIZATION_HPP_INCLUDED
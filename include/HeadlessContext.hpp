@@ -0,0 +1,40 @@
+#ifndef HEADLESSCONTEXT_HPP_INCLUDED
+#define HEADLESSCONTEXT_HPP_INCLUDED
+
+
+#include <string>
+
+#include "NonCopyable.hpp"
+
+
+/**@brief Offscreen OpenGL core context, created without any window.
+ *
+ * Relies on EGL: it first tries Mesa's surfaceless platform (llvmpipe, OSMesa-like setups),
+ * then falls back to a 1x1 pbuffer on the default display.
+ * Nothing is ever rendered to the default framebuffer, all the work is done in FBOs.
+ * GLEW is initialized once the context is current.
+ */
+class HeadlessContext: NonCopyable
+{
+    public:
+        /**@brief Creates the context and makes it current. */
+        HeadlessContext(unsigned int majorVersion=3, unsigned int minorVersion=3);
+        ~HeadlessContext();
+
+        bool isValid() const;
+
+        /**@brief Short description of the OpenGL implementation (version and renderer). */
+        std::string description() const;
+
+    private:
+        bool create(void* display, bool usePbuffer, unsigned int majorVersion, unsigned int minorVersion);
+        void destroy();
+
+    private:
+        void* _display; //EGLDisplay
+        void* _surface; //EGLSurface
+        void* _context; //EGLContext
+        bool _valid;
+};
+
+#endif // HEADLESSCONTEXT_HPP_INCLUDED
@@ -3,7 +3,10 @@
 
 
 #include "glm.hpp"
+#include "VoxelAttributes.hpp"
+#include "SparseGrid.hpp"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -20,6 +23,79 @@ namespace IO
                  std::vector<glm::vec3>& vertices,
                  std::vector<glm::vec3>& normal,
                  std::vector<glm::ivec3>& triangles);
+
+    struct Material
+    {
+        std::string name;
+        glm::vec3 diffuse;
+        std::string diffuseTexture; //path relative to the .mtl file, empty if none
+    };
+
+    /* Loads all the shapes of the file in a single mesh, with the material of each triangle
+     * (index in materials, -1 if none). The .mtl files are looked for next to the .obj.
+     * @return true if success */
+    bool readObj(std::string const& filename,
+                 std::vector<glm::vec3>& vertices,
+                 std::vector<glm::ivec3>& triangles,
+                 std::vector<int>& triangleMaterials,
+                 std::vector<Material>& materials);
+
+    /* Writes a bit-packed voxel grid (see Voxelizer for the layout).
+     * The file starts with a short text header:
+     *     VOXELS 1
+     *     <nbVoxels.x> <nbVoxels.y> <nbVoxels.z>
+     *     <minCorner.x> <minCorner.y> <minCorner.z>
+     *     <voxelSize>
+     * followed by the raw little-endian 32 bits words.
+     * @return true if success */
+    bool writeVoxels(std::string const& filename,
+                     glm::uvec3 const& nbVoxels,
+                     glm::vec3 const& minCorner,
+                     float voxelSize,
+                     std::vector<uint32_t> const& grid);
+
+    /* Writes a sub-voxel occupancy grid (see Voxelizer::coverageGrid), with the same header as writeVoxels
+     * except for the first line "COVERAGE <bitsPerVoxel>", followed by the raw bytes.
+     * @return true if success */
+    bool writeCoverage(std::string const& filename,
+                       glm::uvec3 const& nbVoxels,
+                       glm::vec3 const& minCorner,
+                       float voxelSize,
+                       unsigned int bitsPerVoxel,
+                       std::vector<uint8_t> const& coverage);
+
+    /* Writes a sparse grid (see SparseGrid), with the same header as writeVoxels except for the first line "SPARSE 1",
+     * and a fifth line with the number of bricks. Each brick follows: its coordinates (in bricks) as 3 little-endian
+     * 32 bits words, then its 32x32 words.
+     * @return true if success */
+    bool writeSparseVoxels(std::string const& filename, SparseGrid const& sparse);
+
+    /* Writes the attributes of the set voxels (see VoxelAttributes), in the grid order. Text header:
+     *     ATTRIBUTES 1
+     *     <nbVoxels.x> <nbVoxels.y> <nbVoxels.z>
+     *     <number of attributes> <number of materials>
+     * then one line per material "<name> <diffuse.r> <diffuse.g> <diffuse.b>",
+     * followed by one little-endian record per set voxel: normal as 3 floats, material as an int32.
+     * @return true if success */
+    bool writeAttributes(std::string const& filename,
+                         VoxelAttributes const& attributes,
+                         std::vector<Material> const& materials);
+
+    /* Creates a file in the writeVoxels format with an empty grid, to be filled tile by tile
+     * with writeVoxelsTile, for the grids too large to be held in memory.
+     * @return true if success */
+    bool createVoxelsFile(std::string const& filename,
+                          glm::uvec3 const& nbVoxels,
+                          glm::vec3 const& minCorner,
+                          float voxelSize);
+
+    /* Writes a tile of the grid (see Voxelizer::recomputeTiled) at its place in a file made by createVoxelsFile.
+     * @return true if success */
+    bool writeVoxelsTile(std::string const& filename,
+                         glm::uvec3 const& nbVoxels,
+                         glm::uvec3 const& tileOrigin,
+                         glm::uvec3 const& tileSize,
+                         std::vector<uint32_t> const& tile);
 }
 
 #endif // IO_HPP_INCLUDED
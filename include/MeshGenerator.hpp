@@ -0,0 +1,41 @@
+#ifndef MESHGENERATOR_HPP_INCLUDED
+#define MESHGENERATOR_HPP_INCLUDED
+
+
+#include "glm.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/* Procedural meshes for the benchmarks and the stress tests.
+ * They only depend on their parameters (no std distribution involved), so every platform builds the same triangles. */
+namespace MeshGenerator
+{
+    /* Sphere of radius 1 centered on the origin: an icosahedron whose triangles are split in 4, nbSubdivisions times,
+     * the new vertices being pushed onto the sphere. Closed, 20 * 4^nbSubdivisions triangles (1,310,720 for 8). */
+    void sphere(unsigned int nbSubdivisions,
+                std::vector<glm::vec3>& vertices,
+                std::vector<glm::ivec3>& triangles);
+
+    /* Independent triangles in the unit cube, each within a cube of side maxEdge placed at random.
+     * Not closed, any orientation, many slivers. */
+    void triangleSoup(unsigned int nbTriangles, float maxEdge, uint32_t seed,
+                      std::vector<glm::vec3>& vertices,
+                      std::vector<glm::ivec3>& triangles);
+
+    /* nbPlates square plates of side 1 stacked along Z in the unit cube, each a closed box of this thickness:
+     * features thinner than a voxel, and side faces seen edge-on by two of the projections. */
+    void thinPlates(unsigned int nbPlates, float thickness,
+                    std::vector<glm::vec3>& vertices,
+                    std::vector<glm::ivec3>& triangles);
+
+    /* Builds the mesh described by "sphere:<subdivisions>", "soup:<triangles>" or "plates:<plates>".
+     * @return false if the description isn't one of these */
+    bool generate(std::string const& description,
+                  std::vector<glm::vec3>& vertices,
+                  std::vector<glm::ivec3>& triangles);
+}
+
+#endif // MESHGENERATOR_HPP_INCLUDED
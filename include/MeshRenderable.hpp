@@ -20,6 +20,12 @@ class MeshRenderable
     public:
         /**@brief Loads a .OBJ file. */
         MeshRenderable(std::string const& filename);
+
+        /**@brief Uses already loaded geometry.
+         * If there isn't one normal per vertex, the normals are set to zero. */
+        MeshRenderable(std::vector<glm::vec3> const& vertices,
+                       std::vector<glm::vec3> const& normals,
+                       std::vector<glm::ivec3> const& indices);
         ~MeshRenderable();
 
         glm::mat4& modelMatrix();
@@ -33,6 +39,25 @@ class MeshRenderable
          * Sends vertices normals to location 1. */
         void draw(ShaderProgram& shader) const;
 
+        /**@brief Same as draw, nbInstances times in a single call (gl_InstanceID in the shaders). */
+        void drawInstanced(ShaderProgram& shader, unsigned int nbInstances) const;
+
+        /**@brief Sorts the triangles along each axis, once, so that drawRange can skip most of them.
+         * Keeps a second copy of the indices on the GPU. */
+        void sortTriangles();
+
+        /**@brief Draws (at least) the triangles whose extent along the axis (0 for X, 1 for Y, 2 for Z)
+         * overlaps [minCoord,maxCoord], in the mesh coordinates.
+         * Without sortTriangles, draws the whole mesh. */
+        void drawRange(ShaderProgram& shader, unsigned int axis, float minCoord, float maxCoord) const;
+
+
+    private:
+        /**@brief Uploads the geometry and creates the VAO. */
+        void createBuffers();
+
+        /**@brief VAO on the vertices buffer, with the given indices. */
+        void createVAO(GLuint& vaoId, GLuint indicesBufferId);
 
     private:
         std::vector<glm::vec3> _vertices;
@@ -43,6 +68,14 @@ class MeshRenderable
         GLuint _indicesBufferId;
         GLuint _vaoId;
 
+        /* Triangles sorted by their lowest coordinate along each axis: the range overlapping [a,b]
+         * is contained in the contiguous range of lowest coordinates [a - largest extent, b] */
+        bool _sorted;
+        std::vector<float> _sortedMinCoords[3];
+        float _maxExtents[3];
+        GLuint _sortedIndicesBufferId; //X sorted, then Y sorted, then Z sorted
+        GLuint _sortedVaoId;
+
         glm::mat4 _modelMatrix;
 };
 
@@ -3,6 +3,7 @@
 
 
 #include <string>
+#include <vector>
 #include <unordered_map>
 
 #include "glm.hpp"
@@ -12,7 +13,7 @@
 #include "NonCopyable.hpp"
 
 
-/**@brief Basic class for vertex and fragment shaders.
+/**@brief Basic class for vertex, geometry and fragment shaders.
  *
  * After the compilation, the class performs a resource introspection pass.
  * This is done once to avoid asking the GPU several times later.
@@ -29,11 +30,17 @@ class ShaderProgram: NonCopyable
          * the current shader is not altered. */
         bool loadFromFile(std::string const& vertexFilename, std::string const& fragmentFilename);
 
+        /**@brief Same as above, with a geometry shader stage. */
+        bool loadFromFile(std::string const& vertexFilename, std::string const& geometryFilename, std::string const& fragmentFilename);
+
         /**@brief Attempts to (re)load shader from memory.
          * If for some reason the compilation fails, a message is seend to std::cerr and
          * the current shader is not altered. */
         bool loadFromString(std::string const& vertexShader, std::string const& fragmentShader);
 
+        /**@brief Same as above, with a geometry shader stage (ignored if empty). */
+        bool loadFromString(std::string const& vertexShader, std::string const& geometryShader, std::string const& fragmentShader);
+
         bool isValid() const;
 
         /**@brief Binds a valid shader so it can be used for drawing */
@@ -54,7 +61,15 @@ class ShaderProgram: NonCopyable
 
         static const GLuint nullLocation;
 
+        /**@brief Outputs to capture with transform feedback (interleaved in a single buffer).
+         * Taken into account by the next load, which then doesn't need a fragment shader. */
+        void setTransformFeedbackVaryings(std::vector<std::string> const& varyings);
+
     private:
+        /**@brief Links the compiled shaders into a new program, replacing the current one if success.
+         * The shaders are deleted in any case. */
+        bool linkProgram(std::vector<GLuint> const& shaderIds, std::string const& description);
+
         void queryActiveUniformsLocation();
         void queryActiveAttributesLocation();
 
@@ -64,6 +79,7 @@ class ShaderProgram: NonCopyable
 
       std::unordered_map<std::string, GLint> _uniforms;
       std::unordered_map<std::string, GLint> _attributes;
+      std::vector<std::string> _feedbackVaryings;
 };
 
 #endif // SHADERPROGRAM_HPP_INCLUDED
@@ -0,0 +1,71 @@
+#ifndef SPARSEGRID_HPP_INCLUDED
+#define SPARSEGRID_HPP_INCLUDED
+
+
+#include "glm.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+/**@brief Voxel grid stored by bricks of 32x32x32 voxels, the empty bricks being left out (see Voxelizer::recomputeSparse).
+ *
+ * A brick holds 32x32 words, in the layout of Voxelizer.hpp restricted to the brick:
+ * word (x,y) holds the voxels (x, y, 0-31) of the brick, the words being ordered by Y then X.
+ * A table with one entry per brick of the whole grid gives the index of each stored brick,
+ * so a surface costs 4 KiB per brick it goes through, plus 4 bytes per brick of the whole grid.
+ */
+class SparseGrid
+{
+    public:
+        static const unsigned int BRICK_SIZE = 32;
+        static const unsigned int BRICK_WORDS = BRICK_SIZE * BRICK_SIZE;
+
+    public:
+        /**@brief Creates an empty grid of size 0. */
+        SparseGrid();
+
+        /**@brief Empties the grid, and sets its dimensions (multiples of 32) and position. */
+        void reset(glm::uvec3 const& nbVoxels, glm::vec3 const& minCorner, float voxelSize);
+
+        /**@brief The words of the brick (coordinates in bricks), added with all its voxels empty if it isn't stored yet.
+         * The pointer is valid until the next brick is added. */
+        uint32_t* addBrick(glm::uvec3 const& brick);
+
+        /**@brief The words of the brick (coordinates in bricks), nullptr if it isn't stored. */
+        uint32_t const* brick(glm::uvec3 const& brick) const;
+
+        bool voxel(unsigned int iX, unsigned int iY, unsigned int iZ) const;
+
+        /**@brief The stored bricks, in the order they were added. */
+        std::size_t getNbBricks() const;
+        glm::uvec3 const& brickCoords(std::size_t iBrick) const;
+        uint32_t const* brickWords(std::size_t iBrick) const;
+
+        /**@brief The whole grid, in the layout of Voxelizer::grid(). */
+        std::vector<uint32_t> toGrid() const;
+
+        /**@brief Memory used by the table and the bricks, in bytes. */
+        std::size_t getMemorySize() const;
+
+        glm::uvec3 const& getNbVoxels() const;
+        glm::uvec3 const& getBrickDimensions() const; //number of bricks along each axis
+        glm::vec3 const& getMinCorner() const;
+        float getVoxelSize() const;
+
+    private:
+        std::size_t tableIndex(glm::uvec3 const& brick) const;
+
+    private:
+        glm::uvec3 _nbVoxels;
+        glm::uvec3 _nbBricks;
+        glm::vec3 _minCorner;
+        float _voxelSize;
+
+        std::vector<uint32_t> _table; //index of each brick of the grid plus 1, 0 if not stored
+        std::vector<glm::uvec3> _brickCoords;
+        std::vector<uint32_t> _words; //BRICK_WORDS per stored brick
+};
+
+#endif // SPARSEGRID_HPP_INCLUDED
@@ -0,0 +1,45 @@
+#ifndef TOOLHELPERS_HPP_INCLUDED
+#define TOOLHELPERS_HPP_INCLUDED
+
+
+#include "glm.hpp"
+#include "Voxelizer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/* Command line options and mesh loading shared by the headless tools (voxelize, bench, voxeldiff),
+ * so that they accept the same names. The parsers leave the value untouched and return false on an unknown name. */
+namespace ToolHelpers
+{
+    /* "gpu" or "cpu" */
+    bool parseBackend(std::string const& name, Voxelizer::Backend& backend);
+
+    /* "auto", "projections", "layered", "image" or "dominant" */
+    bool parseGPUMethod(std::string const& name, Voxelizer::GPUMethod& method);
+
+    /* The name parseGPUMethod accepts for this method */
+    std::string gpuMethodName(Voxelizer::GPUMethod method);
+
+    /* "surface", "conservative6", "conservative26" or "solid" */
+    bool parseMode(std::string const& name, Voxelizer::Mode& mode);
+
+    /* Parses "64,128,256", appending to resolutions. @return false if a resolution isn't a positive integer or the list is empty */
+    bool parseResolutions(std::string const& list, std::vector<unsigned int>& resolutions);
+
+    /* Number of set voxels, the words having the layout of Voxelizer.hpp */
+    std::size_t countVoxels(uint32_t const* words, std::size_t nbWords);
+    std::size_t countVoxels(std::vector<uint32_t> const& grid);
+
+    /* A generated mesh (see MeshGenerator::generate) or an .obj file.
+     * @return false, with an error on std::cerr, if the name is neither */
+    bool loadMesh(std::string const& name,
+                  std::vector<glm::vec3>& vertices,
+                  std::vector<glm::vec3>& normals,
+                  std::vector<glm::ivec3>& triangles);
+}
+
+#endif // TOOLHELPERS_HPP_INCLUDED
@@ -0,0 +1,71 @@
+#ifndef VOXELATTRIBUTES_HPP_INCLUDED
+#define VOXELATTRIBUTES_HPP_INCLUDED
+
+
+#include "glm.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+/**@brief Per-voxel attributes, stored for the set voxels of a grid only.
+ *
+ * The attributes are stored in the order of the set bits of the grid (layout documented in Voxelizer.hpp):
+ * the attributes of a voxel are at its rank, the number of set voxels before it in the grid.
+ * Ranks are computed with popcounts in the caller's grid, which isn't copied, from a prefix sum stored every 8 words.
+ * This index still scales with the grid volume: 8 bytes per 8 words, a quarter of the grid size.
+ * The attributes cost memory for the set voxels only.
+ */
+class VoxelAttributes
+{
+    public:
+        struct Attribute
+        {
+            glm::vec3 normal; //average normal of the triangles overlapping the voxel, weighted by their area. Null if none
+            int material; //material of the triangle with the largest area overlapping the voxel, -1 if none
+        };
+
+        static const std::size_t npos;
+
+    public:
+        /**@brief Creates an empty store. */
+        VoxelAttributes();
+
+        /**@brief Computes the attributes of the set voxels of the grid, from the triangles overlapping them.
+         * The voxels set without any triangle overlapping them (inside of a solid) get a null normal and no material.
+         * The grid is referenced, not copied: it must outlive the calls to rank and at, unchanged.
+         * @arg triangleMaterials one material per triangle (-1 for none), may be empty */
+        void compute(std::vector<uint32_t> const& grid,
+                     glm::uvec3 const& nbVoxels,
+                     glm::vec3 const& minCorner,
+                     float voxelSize,
+                     std::vector<glm::vec3> const& vertices,
+                     std::vector<glm::ivec3> const& triangles,
+                     std::vector<int> const& triangleMaterials);
+
+        /**@brief The index of the voxel in attributes(), npos if the voxel isn't set. */
+        std::size_t rank(unsigned int iX, unsigned int iY, unsigned int iZ) const;
+
+        /**@brief The attributes of the voxel, nullptr if it isn't set. */
+        Attribute const* at(unsigned int iX, unsigned int iY, unsigned int iZ) const;
+
+        /**@brief The attributes of all the set voxels, in the grid order. */
+        std::vector<Attribute> const& attributes() const;
+
+        glm::uvec3 const& getNbVoxels() const;
+
+    private:
+        /**@brief Index of the word in the grid, and rank of its first voxel. */
+        std::size_t wordIndex(unsigned int iX, unsigned int iY, unsigned int iZ) const;
+        std::size_t wordRank(std::size_t word) const;
+
+    private:
+        glm::uvec3 _nbVoxels;
+        std::vector<uint32_t> const* _grid; //the caller's, see compute
+        std::vector<uint64_t> _blockRanks; //number of set voxels before each block of 8 words
+
+        std::vector<Attribute> _attributes;
+};
+
+#endif // VOXELATTRIBUTES_HPP_INCLUDED
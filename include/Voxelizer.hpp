@@ -2,21 +2,29 @@
 #define VOXELIZER_HPP_INCLUDED
 
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
 
 #include "ShaderProgram.hpp"
 #include "MeshRenderable.hpp"
 #include "NonCopyable.hpp"
+#include "SparseGrid.hpp"
 
 #include "glm.hpp"
 
 
 /**@brief Computes the voxelization of a mesh.
  *
- * All the computation is handled on GPU.
+ * With the GPU backend, all the computation is handled on GPU.
  * This class uses the hardware rasterization to do the voxelization.
  * It renders the mesh from different points of view, each time adjusting Znear/Zfar planes.
  * Lastly it compiles all these renders to create the final grid.
+ * When OpenGL 4.3 is available, the fragments directly set their voxel in the final grid instead
+ * (see GPUMethod), the whole mesh being rendered in a single draw.
+ *
+ * The CPU backend (see CPUVoxelization.hpp) doesn't need any OpenGL context and
+ * produces the same grid layout, spreading the work over all the cores.
  *
  * The result is accessible through getters methods.
  * It is stored in the following binary format:
@@ -40,11 +48,259 @@
 class Voxelizer: NonCopyable
 {
     public:
-        /**@brief Constructor. Prepares the computation and initializes the grid to be empty. */
-        Voxelizer ();
+        enum class Backend {GPU, CPU};
+
+        /**@brief How the GPU backend writes the voxels.
+         * - Projections (OpenGL 3.3): for each axis, one draw per slab of layers into an integer 3D texture
+         *   (see setSlabWidth), then a pass merges the three projections.
+         * - LayeredProjections (OpenGL 3.3): same, but in Surface mode each axis is a single draw into the
+         *   whole 3D texture attached as a layered framebuffer, a geometry shader sending each triangle
+         *   to the slabs it overlaps through gl_Layer. The other modes, and grids deeper than 64 slabs, draw slab by slab.
+         * - ImageAtomics (OpenGL 4.3): a single draw, where a geometry shader projects each triangle along the
+         *   axes the Projections method would use. The fragments set their bits in an r32ui 3D image with
+         *   imageAtomicOr, already in the grid layout. No intermediate texture, no merge pass. Same voxels as Projections.
+         * - DominantAxis (OpenGL 4.3, opt-in): same, but in Surface mode each triangle is only projected along its
+         *   dominant axis, rasterizing a third of the fragments. A triangle only sets the voxels seen along that axis,
+         *   so the shell is a bit thinner than with Projections. The other modes are the same as ImageAtomics.
+         * - Auto: ImageAtomics if the context supports it, Projections otherwise. */
+        enum class GPUMethod {Auto, Projections, LayeredProjections, ImageAtomics, DominantAxis};
+
+        /**@brief Which voxels of the surface are set.
+         * - Surface: the GPU backend sets the voxels containing the surface at the pixel centers
+         *   of three axis-aligned projections, thin or grazing triangles may leave holes.
+         *   The CPU backend sets every voxel overlapped by the surface (like Conservative6).
+         * - Conservative6: every voxel overlapped by the surface, the result is 6-separating.
+         * - Conservative26: thinner, one voxel thick along each triangle's dominant axis, the result is 26-separating.
+         * - Solid: every voxel whose center is inside the mesh, which must be closed.
+         * With the GPU backend, the conservative modes project each triangle on its dominant axis only,
+         * with conservative rasterization done in a geometry shader.
+         * The solid mode only renders the Z projection: each fragment flips (XOR logic operation) the first voxel
+         * above the surface, then a prefix-XOR sweep along the columns turns the crossings parity into inside states.
+         * Its triangles are never clipped, so a crossing on a slab boundary is counted exactly once. */
+        enum class Mode {Surface, Conservative6, Conservative26, Solid};
+
+        /**@brief Where the GPU backend puts the result.
+         * - Grid: read back into grid().
+         * - Texture: kept on the GPU (see gridTexture), grid() is left empty: no transfer at all.
+         * - GridAndTexture: both, the grid being read back from the texture. */
+        enum class Output {Grid, Texture, GridAndTexture};
+
+        /**@brief Sub-voxel occupancy computed by the GPU backend alongside the grid, from multisampled projections.
+         * - None: no occupancy (default).
+         * - Bits4: 4 bits per voxel, 0 to 15.
+         * - Bits8: 8 bits per voxel, 0 to 255.
+         * In solid mode, the occupancy is the fraction of the voxel cross-section (along Z) inside the mesh at the voxel center.
+         * In the other modes, it is the fraction of the voxel cross-section where the surface goes through the voxel,
+         * along the axis seeing the most of it. */
+        enum class Coverage {None, Bits4, Bits8};
+
+        /**@brief Receives a tile of the grid (see recomputeTiled).
+         * @arg tileOrigin the first voxel of the tile in the whole grid
+         * @arg tileSize the tile dimensions, multiples of 32
+         * @arg tile the tile voxels, in the same layout as grid() */
+        typedef std::function<void(glm::uvec3 const& tileOrigin,
+                                   glm::uvec3 const& tileSize,
+                                   std::vector<uint32_t> const& tile)> TileCallback;
+
+        /**@brief Receives the grid of one transform (see recomputeTransformed).
+         * @arg iTransform the index of the transform
+         * @arg grid the voxels, in the same layout as grid() */
+        typedef std::function<void(std::size_t iTransform,
+                                   std::vector<uint32_t> const& grid)> TransformCallback;
+
+        /**@brief A triangle moved, added or removed by an edit of the mesh (see update), in the mesh coordinates.
+         * An added or removed triangle has the same positions before and after. */
+        struct TriangleChange
+        {
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+        };
+
+        /**@brief Part of the grid, in voxels: [origin, origin+size), multiples of 32. */
+        struct Box
+        {
+            glm::uvec3 origin;
+            glm::uvec3 size;
+        };
+
+        /**@brief Timings of a computation, in milliseconds (see lastStats).
+         * The GPU times are measured by GL_TIME_ELAPSED queries around each pass, 0 for the passes that didn't run;
+         * the computations made of several grids (tiles, boxes, transforms) add them up. The CPU times are wall-clock times. */
+        struct Stats
+        {
+            /* GPU */
+            double xProjection; //Projections methods, one per axis (only Z in solid mode)
+            double yProjection;
+            double zProjection;
+            double imageDraw;   //ImageAtomics: the single draw, clear included
+            double compile;     //merge of the projections, and copy into gridTexture()
+            double readback;    //copy of the grid into the pixel buffer
+            double coverage;    //multisampled projections of the occupancy, and its transfer
+            double pyramid;     //pyramid textures
+
+            /* CPU */
+            double cpuSubmit;   //the computation call until it returns (recompute: without its final wait)
+            double cpuReadback; //waiting for the slabs and copying them into the grid, pyramid levels included
+            double cpuTotal;    //from the call until the grid is final (as seen by wait or the polls)
+        };
+
+    public:
+        /**@brief Constructor. Prepares the computation and initializes the grid to be empty.
+         * The CPU backend doesn't make any OpenGL call.
+         * If the requested GPU method isn't available, Projections is used. */
+        Voxelizer (Backend backend=Backend::GPU, GPUMethod gpuMethod=GPUMethod::Auto);
         ~Voxelizer();
 
-        void recompute(MeshRenderable& mesh, unsigned int resolution);
+        Backend backend() const;
+
+        /**@brief The method actually used by the GPU backend (never Auto). */
+        GPUMethod gpuMethod() const;
+
+        /**@brief Restricts the next computations to the part of the grid overlapping this box, in the mesh coordinates.
+         * The voxels are those of the whole grid (same size and positions), the region being extended
+         * to blocks of 32 voxels of the whole grid: memory and time scale with the region instead of the mesh.
+         * A region outside the mesh bounding box gives an empty grid. */
+        void setRegion(glm::vec3 const& minCorner, glm::vec3 const& maxCorner);
+
+        /**@brief Back to the whole mesh bounding box. */
+        void clearRegion();
+
+        /**@brief Whether the next GPU computations also compute the occupancy (see coverageGrid),
+         * with nbSamples samples per voxel cross-section (at most GL_MAX_INTEGER_SAMPLES).
+         * Not available with the CPU backend, ignored by recomputeTiled. */
+        void setCoverage(Coverage coverage, unsigned int nbSamples=8);
+        Coverage coverage() const;
+
+        /**@brief Occupancy of the last computation, empty if disabled.
+         * Ordered by Z, then Y, then X (fastest). Bits8: one byte per voxel.
+         * Bits4: two voxels per byte, the even X in the 4 low bits. */
+        std::vector<uint8_t> const& coverageGrid() const;
+
+        /**@brief Number of layers rendered by each draw of the Projections methods: 32 (R32UI textures),
+         * 64 (RG32UI) or 128 (RGBA32UI), 32 layers per channel. Wider slabs need fewer draws and merge passes,
+         * but the merge pass fetches wider texels. 0 (default) picks 128 in Solid mode, which has no merge pass, 32 otherwise.
+         * Doesn't change the grid layout, which always has 32 Z-voxels per word. Other values are rounded to one of these. */
+        void setSlabWidth(unsigned int width);
+        unsigned int slabWidth() const;
+
+        /**@brief Where the next GPU computations put their result, Grid by default.
+         * The CPU backend always fills the grid only. */
+        void setOutput(Output output);
+        Output output() const;
+
+        /**@brief The result of the last GPU computation if the output includes Texture, -1 otherwise.
+         * R32UI 3D texture of size (nbVoxels.x, nbVoxels.y, nbVoxels.z/32), in the grid layout:
+         * texel (X, Y, S) holds the voxels (X, Y, 32*S to 32*S+31), bit i being voxel 32*S+i.
+         * Owned by the Voxelizer, it stays valid until the next computation. */
+        GLuint gridTexture() const;
+
+        /**@brief Whether the next computations also build the occupancy pyramid (see pyramidLevel), disabled by default.
+         * Ignored by recomputeTiled, recomputeTransformed and recomputeSparse. */
+        void setPyramid(bool pyramid);
+        bool pyramid() const;
+
+        /**@brief Number of levels of the occupancy pyramid of the last computation, 0 if disabled.
+         * Level 0 is the grid, each next level halves the dimensions of the previous one (rounded up), a voxel being set
+         * if one of its 2x2x2 children is, down to a single voxel. update recomputes the whole pyramid. */
+        unsigned int nbPyramidLevels() const;
+        glm::uvec3 const& pyramidLevelSize(unsigned int level) const;
+
+        /**@brief A level of the pyramid if the output includes Grid, computed on the CPU once the grid is final (empty before).
+         * Same layout as grid(), the Z dimension being rounded up to 32 voxels in the words. Level 0 is grid(). */
+        std::vector<uint32_t> const& pyramidLevel(unsigned int level) const;
+
+        /**@brief A level of the pyramid if the output includes Texture, -1 otherwise. Computed on the GPU from gridTexture(),
+         * same layout, the depth being the Z dimension divided by 32 and rounded up. Level 0 is gridTexture(). */
+        GLuint pyramidTexture(unsigned int level) const;
+
+        /**@brief Computes the grid, and waits for it. */
+        void recompute(MeshRenderable& mesh, unsigned int resolution, Mode mode=Mode::Surface);
+
+        /**@brief Submits the computation, and returns without waiting for the GPU.
+         * The grid is copied back slab by slab (32 Z-layers) through a pixel buffer, with a fence per slab:
+         * use nbReadySlabs/isReady to poll, wait to block. The grid dimensions are available immediately.
+         * A previous pending computation is waited for first. With the CPU backend, this is recompute.
+         * A grid with a side above GL_MAX_3D_TEXTURE_SIZE is rejected with an error and grid() left empty, see recomputeTiled. */
+        void recomputeAsync(MeshRenderable& mesh, unsigned int resolution, Mode mode=Mode::Surface);
+
+        /**@brief Doesn't block. The slabs [0, nbReadySlabs()) of the grid are final. */
+        unsigned int nbReadySlabs();
+
+        /**@brief Doesn't block. Whether the whole grid is final. */
+        bool isReady();
+
+        /**@brief Blocks until the whole grid is final. */
+        void wait();
+
+        /**@brief Voxelization of raw geometry, without any OpenGL resource.
+         * Only available with the CPU backend. */
+        void recompute(std::vector<glm::vec3> const& vertices,
+                       std::vector<glm::ivec3> const& triangles,
+                       unsigned int resolution,
+                       Mode mode=Mode::Surface);
+
+        /**@brief Computes the grid tile by tile, for the grids too large for the GPU textures or the memory.
+         * Each tile (at most tileSize voxels per side, tileSize being a multiple of 32) is computed with
+         * its own frusta, then handed to the callback, in Z, Y, X order. Only one tile is held at once.
+         * During the callback the getters describe the whole grid. Afterwards grid() is left empty.
+         * The GPU output is always Grid. */
+        void recomputeTiled(MeshRenderable& mesh, unsigned int resolution, unsigned int tileSize,
+                            TileCallback const& callback, Mode mode=Mode::Surface);
+
+        /**@brief Same as above, for raw geometry. Only available with the CPU backend. */
+        void recomputeTiled(std::vector<glm::vec3> const& vertices,
+                            std::vector<glm::ivec3> const& triangles,
+                            unsigned int resolution, unsigned int tileSize,
+                            TileCallback const& callback, Mode mode=Mode::Surface);
+
+        /**@brief Computes one grid per transform (model matrix) of the mesh, e.g. to compare many orientations.
+         * All the grids have the voxel size of recompute(mesh, resolution) and the same dimensions, those of the largest
+         * transformed bounding box, each grid being centered on its transformed mesh. Textures, framebuffer and shaders
+         * are set up once: with ImageAtomics, a single instanced draw fills the grids of many transforms at once,
+         * stacked in the same image; the other methods render the transforms one after the other.
+         * The grids are handed to the callback in order, only one being held at once. During the callback the getters
+         * describe the grid of the transform, in the transformed coordinates. Afterwards grid() is left empty.
+         * The region and the coverage are ignored, the GPU output is always Grid. */
+        void recomputeTransformed(MeshRenderable& mesh, std::vector<glm::mat4> const& transforms, unsigned int resolution,
+                                  TransformCallback const& callback, Mode mode=Mode::Surface);
+
+        /**@brief Same as above, for raw geometry. Only available with the CPU backend. */
+        void recomputeTransformed(std::vector<glm::vec3> const& vertices,
+                                  std::vector<glm::ivec3> const& triangles,
+                                  std::vector<glm::mat4> const& transforms, unsigned int resolution,
+                                  TransformCallback const& callback, Mode mode=Mode::Surface);
+
+        /**@brief Updates the grid of the last recompute after a local edit of the mesh, which now holds the edited geometry.
+         * Only the 32x32x32 blocks overlapped by the changed triangles (before or after the edit) are recomputed,
+         * merged into boxes (see updatedBoxes), the rest of the grid is kept. The grid keeps its dimensions and position,
+         * so the geometry moved out of it is ignored: recompute when the bounding box changes a lot.
+         * Uses the mode of the last recompute, the coverage is ignored. Needs the grid in memory: the output must include Grid.
+         * With GridAndTexture, the boxes are also updated in gridTexture(). In solid mode the mesh must stay closed. */
+        void update(MeshRenderable& mesh, std::vector<TriangleChange> const& changes);
+
+        /**@brief Same as above, for raw geometry. Only available with the CPU backend. */
+        void update(std::vector<glm::vec3> const& vertices,
+                    std::vector<glm::ivec3> const& triangles,
+                    std::vector<TriangleChange> const& changes);
+
+        /**@brief The parts of the grid recomputed by the last update, in Z, Y, X order, disjoint.
+         * Empty after the other computations. */
+        std::vector<Box> const& updatedBoxes() const;
+
+        /**@brief Computes the grid in bricks of 32x32x32 voxels, only storing the bricks the surface goes through,
+         * for the high resolutions where most of the grid is empty: time and memory follow the surface area instead of the volume.
+         * A coarse pass on the CPU finds the bricks overlapped by the triangles (with a margin of one voxel), then only these
+         * are voxelized at full resolution. With ImageAtomics, a single draw writes the fragments through a table of the
+         * bricks into a pool holding only them. The other methods and the CPU backend compute boxes of occupied bricks,
+         * each with its own frusta (or its own triangles on CPU), like the tiles of recomputeTiled.
+         * The bricks left empty are dropped. Solid mode isn't available (the inside isn't sparse). grid() is left empty,
+         * the getters describe the whole grid. The coverage is ignored, the GPU output is always Grid. */
+        void recomputeSparse(MeshRenderable& mesh, unsigned int resolution, SparseGrid& sparse, Mode mode=Mode::Surface);
+
+        /**@brief Same as above, for raw geometry. Only available with the CPU backend. */
+        void recomputeSparse(std::vector<glm::vec3> const& vertices,
+                             std::vector<glm::ivec3> const& triangles,
+                             unsigned int resolution, SparseGrid& sparse, Mode mode=Mode::Surface);
 
         /**@brief Access to the raw grid data. */
         std::vector<uint32_t> const& grid() const;
@@ -52,36 +308,251 @@ class Voxelizer: NonCopyable
         /**@brief The grid dimensions. */
         glm::uvec3 const& getNbVoxels() const;
 
+        /**@brief The dimensions of the grid recompute would build for these vertices at this resolution,
+         * without the region, e.g. to check them against GL_MAX_3D_TEXTURE_SIZE beforehand. */
+        static glm::uvec3 gridSize(std::vector<glm::vec3> const& vertices, unsigned int resolution);
+
+        /**@brief The corner of the grid with the lowest coordinates, in the mesh coordinates. */
+        glm::vec3 const& getMinCorner() const;
+
         /**@brief The size of a voxel, to fit the voxel grid on the original mesh. */
         float getVoxelSize() const;
 
         /**@brief The position of a voxel in the mesh coordinates. */
         glm::vec3 voxelPosition(unsigned int iX, unsigned int iY, unsigned int iZ) const;
 
+        /**@brief Timings of the last computation. The GPU times not collected yet (they are when the readback ends)
+         * are collected here, waiting for the GPU to finish the timed passes. The CPU backend only has CPU times. */
+        Stats const& lastStats() const;
+
+        /**@brief Releases the GPU textures and VAO kept between computations.
+         * They are recreated when needed. */
+        void trim();
+
 
     private:
-        /**@brief Computes the optimal 3D grid dimensions. */
-        void computeGridSize(MeshRenderable const& mesh, unsigned int resolution);
+        /**@brief Computes the optimal 3D grid dimensions, restricted to the region if any. */
+        void computeGridSize(std::vector<glm::vec3> const& vertices, unsigned int resolution);
+
+        /**@brief Computes the common dimensions and voxel size of the transformed grids, and the min corner of each. */
+        void computeTransformedGridSizes(std::vector<glm::vec3> const& vertices, std::vector<glm::mat4> const& transforms,
+                                         unsigned int resolution, std::vector<glm::vec3>& minCorners);
+
+        /**@brief Makes the grid of the transform the current one, and empties it. */
+        void selectTransformedGrid(glm::vec3 const& minCorner);
+
+        /**@brief Finds the boxes of the grid overlapped by the changes, @return false if there is no grid to update. */
+        bool computeUpdatedBoxes(std::vector<TriangleChange> const& changes);
+
+        /**@brief Runs computeBox on each updated box, each becoming the grid in turn, and merges the results in the grid. */
+        void forEachUpdatedBox(std::function<void()> const& computeBox);
+
+        /**@brief Each box becomes the grid in turn (empty, with its own corners), while computeBox fills and uses it. */
+        void forEachBox(std::vector<Box> const& boxes, std::function<void(Box const&)> const& computeBox);
+
+        /**@brief Coarse pass of recomputeSparse: sets table to the index plus 1 of each brick overlapped by the triangles,
+         * 0 for the others, the bricks being numbered in Z, Y, X order. If brickTriangles isn't null, it gets the triangles of each brick.
+         * @return the number of overlapped bricks */
+        std::size_t computeOccupiedBricks(std::vector<glm::vec3> const& vertices, std::vector<glm::ivec3> const& triangles,
+                                          std::vector<uint32_t>& table,
+                                          std::vector<std::vector<unsigned int>>* brickTriangles);
+
+        /**@brief Prepares recomputeSparse, @return false if the grid can't be computed */
+        bool startSparse(std::vector<glm::vec3> const& vertices, unsigned int resolution, SparseGrid& sparse, Mode mode);
+
+        /**@brief Copies the non-empty bricks of the box, which is the current grid, to the sparse grid. */
+        void keepBricks(Box const& box, SparseGrid& sparse) const;
+
+        /**@brief Fills the bricks of the table (see computeOccupiedBricks) with image atomic operations, in a single draw.
+         * @return false if the pool of bricks doesn't fit in a texture */
+        bool computeSparseVoxelsWithImage(MeshRenderable& mesh, Mode mode, std::vector<uint32_t> const& table,
+                                          std::size_t nbBricks, SparseGrid& sparse);
+
+        /**@brief Splits the grid computed by computeGridSize into tiles, and runs computeTile on each. */
+        void forEachTile(unsigned int tileSize, TileCallback const& callback, std::function<void()> const& computeTile);
+
+        /**@brief Fills the 3D grid with the CPU backend. A tile or a box is computed in the whole grid coordinates,
+         * giving the same words as the whole grid. */
+        void computeVoxelsOnCPU(std::vector<glm::vec3> const& vertices, std::vector<glm::ivec3> const& triangles, Mode mode);
+
+        /**@brief Loads the shaders of the method, @return false if one of them is invalid. */
+        bool loadShaders(GPUMethod method);
+
+        /**@brief ImageAtomics or DominantAxis, which share the image shaders and passes. */
+        bool usesImageAtomics() const;
 
         /**@brief Fills the 3D grid */
-        void computeVoxels(MeshRenderable& mesh);
+        void computeVoxels(MeshRenderable& mesh, Mode mode);
+
+        /**@brief Binds the framebuffer (without attachment) and the shader of an image pass, and sets the state and the
+         * uniforms shared by all of them (dense, transformed and sparse). The shader only gets the uniforms it declares. */
+        void setupImagePass(ShaderProgram& shader, Mode mode);
+
+        /**@brief Clears the r32ui texture and binds it to the image unit 0, within the framebuffer of setupImagePass. */
+        void bindClearedImage(GLuint textureId);
+
+        /**@brief Same as above, with image atomic operations */
+        void computeVoxelsWithImage(MeshRenderable& mesh, Mode mode);
+
+        /**@brief Fills the grids of all the transforms with image atomic operations, by chunks of instanced draws,
+         * and hands them to the callback. */
+        void computeTransformedVoxelsWithImage(MeshRenderable& mesh, std::vector<glm::mat4> const& transforms,
+                                               std::vector<glm::vec3> const& minCorners,
+                                               TransformCallback const& callback, Mode mode);
 
         enum class Axis {X, Y, Z};
-        void drawSlice (MeshRenderable& mesh, Axis axis, unsigned int slice);
+        /**@brief Fills the occupancy grid, rendering the projections again in multisampled textures */
+        void computeCoverage(MeshRenderable& mesh, Mode mode);
+
+        /**@brief Empties the pyramid, giving its textures back to the pool. */
+        void releasePyramid();
+
+        /**@brief Builds the pyramid of the grid just computed if enabled: the textures at once, the levels in memory once the grid is final. */
+        void startPyramid();
+
+        /**@brief Computes the levels in memory from the grid, level by level */
+        void computePyramidLevels();
+
+        /**@brief Computes the level textures from gridTexture(), one pass per slab of each level */
+        void computePyramidTextures();
+
+        /**@brief Copies the result into a new R32UI texture in the grid layout, which becomes gridTexture().
+         * @arg nbChannels number of 32 Z-voxels words per texel of the source (1, 2 or 4)
+         * @arg sweep whether to apply the solid mode prefix-XOR sweep */
+        void keepGridTexture(GLuint textureId, unsigned int nbChannels, bool sweep);
+
+        /**@brief Queues the copy of the grid texture (nbChannels slabs per layer) into the pixel buffer.
+         * The grid starts at the layer firstLayer of the texture. */
+        void startReadback(GLuint textureId, unsigned int nbChannels, bool sweep, unsigned int firstLayer=0);
+
+        /**@brief Copies the slabs already transferred to the grid, waiting at most timeout nanoseconds for the next one.
+         * @return the number of ready slabs */
+        unsigned int updateReadback(GLuint64 timeout);
+
+        /**@brief Renders the mesh (transformed by the current mesh transform) with near/far planes enclosing the nbLayers layers starting at slice.
+         * With includeBelow, the triangles below the slice are drawn too (solid mode crossings). */
+        void drawSlice (MeshRenderable& mesh, ShaderProgram& shader, Axis axis, unsigned int slice, unsigned int nbLayers=32, bool includeBelow=false);
+
+        /**@brief Returns a 3D texture of this format and size, reused from the pool if possible.
+         * Its content is undefined. */
+        GLuint acquireTexture(GLenum internalFormat, glm::uvec3 const& size);
+
+        /**@brief Gives a texture back to the pool, for the next computations. */
+        void releaseTexture(GLuint textureId);
+
+        /**@brief Forgets the timings of the previous computation, and starts the clock of the new one. */
+        void resetStats();
+
+        /**@brief Records the submission time of the computation started by resetStats. */
+        void endSubmit();
+
+        /**@brief Starts a GL_TIME_ELAPSED query, to be added to this field of the stats. Only one can be running at once. */
+        void beginTimer(double Stats::* phase);
+        void endTimer();
+
+        /**@brief Adds the results of the queries issued so far to the stats, waiting for them if needed. */
+        void collectTimers() const;
+
+        /**@brief Issues a throwaway query around a tiny clear: llvmpipe gives garbage for the first
+         * GL_TIME_ELAPSED query of a context that renders anything, every later one being right.
+         * Only on llvmpipe, and once per context (by its EGL or GLX handle, once in all if none is found). */
+        void discardFirstTimer();
+
+        /**@brief VAO without any attribute, for the full-viewport passes. */
+        GLuint emptyVAO();
+
+        /**@brief Renders all the slabs of the axis at once, the whole texture being attached as layered. */
+        void drawLayers (MeshRenderable& mesh, Axis axis, GLuint textureId, unsigned int width, unsigned int height,
+                         unsigned int nbLayers, unsigned int slabWidth);
 
 
     private:
+        Backend _backend;
+        GPUMethod _gpuMethod;
+
         glm::uvec3 _nbVoxels; //should be multiples of 4
         float _voxelSize;
 
         glm::vec3 _minCorner;
         glm::vec3 _maxCorner;
 
+        /* During forEachTile and forEachBox: the first voxel of the part in the whole grid, and the corner of the whole grid */
+        glm::uvec3 _partOrigin;
+        glm::vec3 _wholeMinCorner;
+
+        bool _hasRegion;
+        glm::vec3 _regionMin;
+        glm::vec3 _regionMax;
+
         std::vector<uint32_t> _voxels;
 
+        glm::mat4 _meshTransform; //applied to the mesh before the voxelization, see recomputeTransformed
+
+        Mode _mode; //of the last recompute, for update
+        std::vector<Box> _updatedBoxes;
+
+        Coverage _coverage;
+        unsigned int _nbCoverageSamples;
+        std::vector<uint8_t> _coverageGrid;
+
+        bool _pyramid;
+        bool _pyramidPending; //the levels are computed when the readback ends
+        std::vector<glm::uvec3> _pyramidSizes; //from level 0
+        std::vector<std::vector<uint32_t>> _pyramidLevels; //from level 1
+        std::vector<GLuint> _pyramidTextureIds; //from level 1
+
+        unsigned int _slabWidth;
+
+        Output _output;
+        GLuint _gridTextureId; //kept result
+
         GLuint _framebufferId;
+
+        /* GPU resources kept between computations */
+        struct PooledTexture
+        {
+            GLuint id;
+            GLenum internalFormat;
+            glm::uvec3 size;
+            bool inUse;
+        };
+        std::vector<PooledTexture> _texturePool; //the idle ones in release order
+        GLuint _emptyVaoId;
+
+        /* Pending readback: one fence per texture layer, in order */
+        GLuint _readbackBufferId;
+        std::size_t _readbackBufferSize;
+        unsigned int _readbackNbChannels; //slabs per layer
+        std::vector<GLsync> _readbackFences;
+        unsigned int _nbReadySlabs;
+        bool _readbackSweep; //solid mode
+        std::vector<uint32_t> _sweepCarries;
+
+        /* Timings of the last computation: a pool of queries, the first ones waiting to be collected */
+        mutable Stats _stats;
+        std::chrono::steady_clock::time_point _statsStart;
+        std::vector<GLuint> _timerQueryIds;
+        mutable std::vector<double Stats::*> _pendingTimers; //field of each issued query, in pool order
+
+        /* Grid matrices of the instanced draws, as a buffer texture */
+        GLuint _gridMatricesBufferId;
+        GLuint _gridMatricesTextureId;
+
         ShaderProgram _sliceShader;
+        ShaderProgram _layeredSliceShader;
+        ShaderProgram _conservativeSliceShader;
+        ShaderProgram _solidSliceShader;
         ShaderProgram _compileShader;
+        ShaderProgram _gridTextureShader;
+        ShaderProgram _coverageShader;
+        ShaderProgram _pyramidShader;
+
+        ShaderProgram _flatImageShader;
+        ShaderProgram _conservativeImageShader;
+        ShaderProgram _solidImageShader;
+        ShaderProgram _instancedFlatImageShader;
+        ShaderProgram _instancedConservativeImageShader;
+        ShaderProgram _instancedSolidImageShader;
 };
 
 
@@ -0,0 +1,66 @@
+#ifndef VOXELIZERBATCH_HPP_INCLUDED
+#define VOXELIZERBATCH_HPP_INCLUDED
+
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Voxelizer.hpp"
+#include "MeshRenderable.hpp"
+#include "NonCopyable.hpp"
+
+
+/**@brief Voxelizes a list of meshes, keeping several computations in flight on the GPU.
+ *
+ * Each of the nbInFlight Voxelizers has its own textures and readback buffer, so a job is submitted
+ * (see Voxelizer::recomputeAsync) while the previous ones are still computed or transferred:
+ * the GPU doesn't idle between jobs waiting for the readback.
+ * The results are handed to the callback in the job order.
+ */
+class VoxelizerBatch: NonCopyable
+{
+    public:
+        struct Job
+        {
+            MeshRenderable* mesh;
+            unsigned int resolution;
+            Voxelizer::Mode mode;
+        };
+
+        /**@brief Receives the result of a job, through the getters of the Voxelizer that computed it.
+         * They are valid during the callback only. */
+        typedef std::function<void(std::size_t iJob, Voxelizer const& result)> ResultCallback;
+
+        struct Stats
+        {
+            std::size_t nbMeshes;
+            std::size_t nbVoxels; //voxels of the grids, set or not
+            double seconds; //from the first submission to the last callback, callbacks included
+
+            double meshesPerSecond() const;
+            double voxelsPerSecond() const;
+        };
+
+    public:
+        /**@brief Creates nbInFlight Voxelizers (at least 1), all with the same backend and method.
+         * With the CPU backend, the jobs are computed one after the other. */
+        VoxelizerBatch(unsigned int nbInFlight=3,
+                       Voxelizer::Backend backend=Voxelizer::Backend::GPU,
+                       Voxelizer::GPUMethod gpuMethod=Voxelizer::GPUMethod::Auto);
+
+        unsigned int nbInFlight() const;
+
+        /**@brief The i-th Voxelizer, to change its settings (region, output, coverage...).
+         * The jobs are spread over all of them, so they should share the same settings. */
+        Voxelizer& voxelizer(unsigned int i);
+
+        /**@brief Computes all the jobs, and returns once every callback has been called. */
+        Stats run(std::vector<Job> const& jobs, ResultCallback const& callback);
+
+    private:
+        std::vector<std::unique_ptr<Voxelizer>> _voxelizers;
+};
+
+#endif // VOXELIZERBATCH_HPP_INCLUDED
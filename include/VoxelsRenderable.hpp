@@ -16,6 +16,8 @@
 /**@brief Voxel grid visualization.
  *
  * Can display the grid in the current active OpenGL context. Uses instanciation to save memory.
+ * When the Voxelizer keeps its result on the GPU (see Voxelizer::gridTexture), the cubes positions
+ * are extracted from the texture by transform feedback, without any transfer to the CPU.
  */
 class VoxelsRenderable: NonCopyable
 {
@@ -30,6 +32,12 @@ class VoxelsRenderable: NonCopyable
         void draw(ShaderProgram& shader) const;
 
     private:
+        /**@brief Fills the positions buffer from the CPU grid. */
+        void positionsFromGrid(Voxelizer const& voxelizer);
+
+        /**@brief Fills the positions buffer from the grid texture, on the GPU. */
+        void positionsFromTexture(Voxelizer const& voxelizer);
+
         /**@brief Appends an indexed cube mesh to the given arrays. */
         void addCube(float cubeSize, glm::vec3 center,
                      std::vector<glm::vec3>& vertices,
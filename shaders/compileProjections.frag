@@ -1,67 +1,58 @@
 #version 330
 
 
-uniform usampler3D xProjTex; //(y, z, x)
-uniform usampler3D yProjTex; //(x, z, y)
+/* Merges the X and Y projections into one slab of the Z projection.
+ * Each texel holds slabWidth layers, 32 per channel. */
+
+uniform usampler3D xProjTex; //(y, z), layer x/slabWidth
+uniform usampler3D yProjTex; //(x, z), layer y/slabWidth
 
 uniform vec3 gridSize;
+uniform uint slabWidth;
 
 in vec3 texelCoord; //voxel coordinates, non normalized
 
 out uvec4 fragColor;
 
 
-uvec4 byteToColor(const uint v)
+/* Bit of voxel i in a texel of the projections */
+uvec4 voxelMask(const uint i)
 {
-    uint r = v >> 24u;
-    uint g = (v & 0x00FF0000u) >> 16u;
-    uint b = (v & 0x0000FF00u) >> 8u;
-    uint a = v & 0x000000FFu;
-    
-    return uvec4(r, g, b, a);
+    uint channel = (i % slabWidth) / 32u;
+    uint bit = 1u << (i % 32u);
+    return uvec4(channel == 0u ? bit : 0u, channel == 1u ? bit : 0u,
+                 channel == 2u ? bit : 0u, channel == 3u ? bit : 0u);
 }
 
-uint colorToByte(const uvec4 color)
+/* 32 voxels of the column from layer first, those beyond the slab or the grid being 0 */
+uint mergeWord(const uint x, const uint y, const uint first, const uvec4 xMask, const uvec4 yMask)
 {
-    return (uint(color.r) << 24u) |
-           (uint(color.g) << 16u) |
-           (uint(color.b) << 8u)  |
-            uint(color.a);
+    uint end = min(uint(texelCoord.z) + slabWidth, uint(gridSize.z));
+    if (first >= end)
+        return 0u;
+
+    int lastLayer = int(end) - 1;
+    uint word = 0u;
+    for (int bZ = 0 ; bZ < 32 ; ++bZ) {
+        int z = min(int(first) + bZ, lastLayer);
+        uvec4 v = (texelFetch(xProjTex, ivec3(y, z, x / slabWidth), 0) & xMask) |
+                  (texelFetch(yProjTex, ivec3(x, z, y / slabWidth), 0) & yMask);
+        if (any(notEqual(v, uvec4(0u))))
+            word |= 1u << uint(bZ);
+    }
+    return (end - first >= 32u) ? word : (word & ((1u << (end - first)) - 1u));
 }
 
 void main()
 {
-    vec3 texelSize = 1.0 / (gridSize-1.0);
-    
     uint x = uint(texelCoord.x);
     uint y = uint(texelCoord.y);
     uint z = uint(texelCoord.z);
-    
-    uint iX = x / 32u;
-    uint bX = x % 32u;
-    
-    uint iY = y / 32u;
-    uint bY = y % 32u;
-    
-    uint xProj = 0u, yProj = 0u;
-    vec3 coords;
-    uint v;
-    for (uint bZ = 0u ; bZ < 32u ; ++bZ) {
-        /* Reading X projection texture */
-        coords = vec3(y, z + bZ, iX) * vec3(texelSize.yz, 32.0 * texelSize.x);
-        v = colorToByte(texture(xProjTex, coords));
-        if ((v & (1u << bX)) != 0u)
-            xProj = xProj | (1u << bZ);
-        
-        /* Reading Y projection texture */
-        coords = vec3(x, z + bZ, iY) * vec3(texelSize.xz, 32.0*texelSize.y);
-        v = colorToByte(texture(yProjTex, coords));
-        if ((v & (1u << bY)) != 0u)
-            yProj = yProj | (1u << bZ);
-    }
-    
-    fragColor = byteToColor(xProj | yProj);
-    
-    //fragColor = uvec4(0, y, 0, 0);
-    //fragColor = byteToColor(2355425u);//uvec4(0u);
+    uvec4 xMask = voxelMask(x);
+    uvec4 yMask = voxelMask(y);
+
+    fragColor = uvec4(mergeWord(x, y, z, xMask, yMask),
+                      mergeWord(x, y, z + 32u, xMask, yMask),
+                      mergeWord(x, y, z + 64u, xMask, yMask),
+                      mergeWord(x, y, z + 96u, xMask, yMask));
 }
@@ -0,0 +1,76 @@
+#version 430
+
+
+/* Same as conservativeSlice.frag, but the triangle comes from dominantAxis.geom
+ * and the voxels are directly written in the grid. */
+
+layout(r32ui, binding = 0) uniform uimage3D grid; //(X, Y, Z/32), bit Z%32, grids stacked along the depth
+
+uniform uvec3 gridSize;
+uniform uint slabsPerGrid; //only needed with several grids
+uniform uint separability; //6 or 26
+
+const float depthMargin = 1.0 / 4096.0; //see conservativeSlice.frag
+
+/* Sparse grid, see flatImage.frag */
+uniform bool sparse;
+uniform uint bricksPerLayer;
+layout(r32ui, binding = 1) readonly uniform uimage3D brickTable;
+
+flat in uint axis;
+flat in int gridInstance;
+flat in vec4 plane;
+flat in vec3 triangleMin;
+flat in vec3 triangleMax;
+
+
+/* Pixels are (Y,Z) for the X axis, (X,Z) for the Y axis and (X,Y) for the Z axis */
+ivec3 voxelCoords(const ivec2 pixel, const int depth)
+{
+    if (axis == 0u)
+        return ivec3(depth, pixel);
+    else if (axis == 1u)
+        return ivec3(pixel.x, depth, pixel.y);
+    return ivec3(pixel, depth);
+}
+
+/* See flatImage.frag */
+void setVoxel(const ivec3 voxel)
+{
+    if (!sparse) {
+        imageAtomicOr(grid, ivec3(voxel.xy, voxel.z / 32 + gridInstance * int(slabsPerGrid)), 1u << uint(voxel.z % 32));
+        return;
+    }
+
+    uint index = imageLoad(brickTable, voxel / 32).r;
+    if (index == 0u)
+        return;
+    --index;
+    ivec2 local = voxel.xy % 32;
+    imageAtomicOr(grid, ivec3(local.x, local.y + 32 * int(index % bricksPerLayer), int(index / bricksPerLayer)), 1u << uint(voxel.z % 32));
+}
+
+void main()
+{
+    /* The column covers [pixel, pixel+1] */
+    vec2 pixel = floor(gl_FragCoord.xy);
+    if (any(greaterThan(pixel, triangleMax.xy)) || any(lessThan(pixel + 1.0, triangleMin.xy)))
+        discard;
+
+    /* See conservativeSlice.frag */
+    vec3 n = plane.xyz;
+    vec2 center = pixel + 0.5;
+    float depth = (plane.w - dot(n.xy, center)) / n.z;
+    float halfThickness = 0.5 + depthMargin;
+    if (separability == 6u)
+        halfThickness += 0.5 * (abs(n.x) + abs(n.y)) / abs(n.z);
+
+    int first = max(int(ceil(depth - halfThickness - 0.5)), int(ceil(triangleMin.z)) - 1);
+    int last = min(int(floor(depth + halfThickness - 0.5)), int(floor(triangleMax.z)));
+
+    for (int layer = max(first, 0) ; layer <= last ; ++layer) {
+        ivec3 voxel = voxelCoords(ivec2(pixel), layer);
+        if (all(lessThan(uvec3(voxel), gridSize)))
+            setVoxel(voxel);
+    }
+}
@@ -0,0 +1,60 @@
+#version 330
+
+
+/* 6: every voxel whose box is crossed by the triangle's plane (thick, 6-separating).
+ * 26: only the voxels crossed by the plane along the projection axis (thin, 26-separating). */
+uniform uint separability;
+uniform uint slabWidth; //layers per texel: 32 per channel of the target
+
+const float depthMargin = 1.0 / 4096.0; //in voxels, for the rounding of the depth (a plane on a voxel face counts)
+
+flat in vec4 plane;
+flat in vec3 triangleMin;
+flat in vec3 triangleMax;
+
+out uvec4 fragColor;
+
+
+/* Layers first to last of the texel, 32 per channel */
+uvec4 rangeToColor(const int first, const int last)
+{
+    uvec4 color = uvec4(0u);
+    for (int i = 0 ; i < 4 ; ++i) {
+        int from = max(first - 32 * i, 0);
+        int to = min(last - 32 * i, 31);
+        if (from > to)
+            continue;
+
+        uint upTo = (to == 31) ? 0xFFFFFFFFu : ((1u << uint(to + 1)) - 1u);
+        color[i] = upTo & ~((1u << uint(from)) - 1u);
+    }
+    return color;
+}
+
+void main()
+{
+    /* The column covers [pixel, pixel+1] */
+    vec2 pixel = floor(gl_FragCoord.xy);
+    if (any(greaterThan(pixel, triangleMax.xy)) || any(lessThan(pixel + 1.0, triangleMin.xy)))
+        discard;
+
+    /* Depth of the plane at the column center.
+     * The plane crosses the voxel centered on c if |dot(n,c) - d| <= r, with
+     * r = (|n.x|+|n.y|+|n.z|)/2 for 6-separability, r = |n.z|/2 for 26-separability (n.z is dominant). */
+    vec3 n = plane.xyz;
+    vec2 center = pixel + 0.5;
+    float depth = (plane.w - dot(n.xy, center)) / n.z;
+    float halfThickness = 0.5 + depthMargin;
+    if (separability == 6u)
+        halfThickness += 0.5 * (abs(n.x) + abs(n.y)) / abs(n.z);
+
+    /* Voxel k is centered on k+0.5, and must overlap the triangle's depth range */
+    int first = max(int(ceil(depth - halfThickness - 0.5)), int(ceil(triangleMin.z)) - 1);
+    int last = min(int(floor(depth + halfThickness - 0.5)), int(floor(triangleMax.z)));
+    first = max(first, 0);
+    last = min(last, int(slabWidth) - 1);
+    if (first > last)
+        discard;
+
+    fragColor = rangeToColor(first, last);
+}
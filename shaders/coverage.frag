@@ -0,0 +1,61 @@
+#version 330
+
+
+/* Occupancy of the voxels of one Z-layer, from the multisampled projections (one R32UI layer per 32 slices, see computeCoverage).
+ * Surface: fraction of the samples of the voxel cross-section where the surface goes through the voxel, the largest of the 3 axes.
+ * Solid: fraction of the samples of the voxel cross-section inside the mesh at the voxel center (Z projection only). */
+
+uniform usampler2DMSArray xProjTex; //(y, z), layer x/32
+uniform usampler2DMSArray yProjTex; //(x, z), layer y/32
+uniform usampler2DMSArray zProjTex; //(x, y), layer z/32
+
+uniform int nbSamples;
+uniform int layer; //Z of the voxels
+uniform bool solid;
+uniform float maxValue; //occupancy of a fully covered voxel
+
+out uint occupancy;
+
+
+uint parity(uint v)
+{
+    v ^= v >> 16u;
+    v ^= v >> 8u;
+    v ^= v >> 4u;
+    v ^= v >> 2u;
+    v ^= v >> 1u;
+    return v & 1u;
+}
+
+int countSamples(const usampler2DMSArray tex, const ivec2 pixel, const int depth)
+{
+    int count = 0;
+    for (int iS = 0 ; iS < nbSamples ; ++iS) {
+        uint v = texelFetch(tex, ivec3(pixel, depth / 32), iS).r;
+        count += int((v >> uint(depth % 32)) & 1u);
+    }
+    return count;
+}
+
+void main()
+{
+    ivec3 voxel = ivec3(ivec2(gl_FragCoord.xy), layer);
+
+    int count = 0;
+    if (solid) {
+        /* Each sample has its own crossings: inside if their number up to the voxel is odd */
+        uint below = (voxel.z % 32 == 31) ? 0xFFFFFFFFu : ((1u << uint(voxel.z % 32 + 1)) - 1u);
+        for (int iS = 0 ; iS < nbSamples ; ++iS) {
+            uint crossings = texelFetch(zProjTex, ivec3(voxel.xy, voxel.z / 32), iS).r & below;
+            for (int iL = 0 ; iL < voxel.z / 32 ; ++iL)
+                crossings ^= texelFetch(zProjTex, ivec3(voxel.xy, iL), iS).r;
+            count += int(parity(crossings));
+        }
+    } else {
+        count = countSamples(zProjTex, voxel.xy, voxel.z);
+        count = max(count, countSamples(xProjTex, voxel.yz, voxel.x));
+        count = max(count, countSamples(yProjTex, voxel.xz, voxel.y));
+    }
+
+    occupancy = uint(floor(float(count) * maxValue / float(nbSamples) + 0.5));
+}
@@ -0,0 +1,56 @@
+#version 430
+
+
+/* Same as flatSlice.frag, but the triangle comes from dominantAxis.geom
+ * and the voxel is directly written in the grid. */
+
+layout(r32ui, binding = 0) uniform uimage3D grid; //(X, Y, Z/32), bit Z%32, grids stacked along the depth
+
+uniform uvec3 gridSize;
+uniform uint slabsPerGrid; //only needed with several grids
+
+/* Sparse grid (see Voxelizer::recomputeSparse): the grid is a pool of 32x32x32 bricks stacked along Y then the depth,
+ * the table giving the index plus 1 of the brick of each block of 32 voxels, 0 if it isn't stored */
+uniform bool sparse;
+uniform uint bricksPerLayer;
+layout(r32ui, binding = 1) readonly uniform uimage3D brickTable;
+
+flat in uint axis;
+flat in int gridInstance;
+in float layer;
+
+
+/* Pixels are (Y,Z) for the X axis, (X,Z) for the Y axis and (X,Y) for the Z axis */
+ivec3 voxelCoords(const ivec2 pixel, const int depth)
+{
+    if (axis == 0u)
+        return ivec3(depth, pixel);
+    else if (axis == 1u)
+        return ivec3(pixel.x, depth, pixel.y);
+    return ivec3(pixel, depth);
+}
+
+/* In the grid, or in its brick of the pool if it is stored */
+void setVoxel(const ivec3 voxel)
+{
+    if (!sparse) {
+        imageAtomicOr(grid, ivec3(voxel.xy, voxel.z / 32 + gridInstance * int(slabsPerGrid)), 1u << uint(voxel.z % 32));
+        return;
+    }
+
+    uint index = imageLoad(brickTable, voxel / 32).r;
+    if (index == 0u)
+        return;
+    --index;
+    ivec2 local = voxel.xy % 32;
+    imageAtomicOr(grid, ivec3(local.x, local.y + 32 * int(index % bricksPerLayer), int(index / bricksPerLayer)), 1u << uint(voxel.z % 32));
+}
+
+void main()
+{
+    ivec3 voxel = voxelCoords(ivec2(gl_FragCoord.xy), int(floor(layer)));
+    if (any(lessThan(voxel, ivec3(0))) || any(greaterThanEqual(uvec3(voxel), gridSize)))
+        discard;
+
+    setVoxel(voxel);
+}
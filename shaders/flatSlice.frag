@@ -1,32 +1,20 @@
 #version 330
 
 
+uniform uint slabWidth; //layers per texel: 32 per channel of the target
+
 out uvec4 fragColor;
 
 
-uvec4 byteToColor(const uint v)
-{
-    uint r = v >> 24u;
-    uint g = (v & 0x00FF0000u) >> 16u;
-    uint b = (v & 0x0000FF00u) >> 8u;
-    uint a = v & 0x000000FFu;
-    
-    return uvec4(r, g, b, a);
-}
-
-uint colorToByte(const uvec4 color)
-{
-    return (uint(color.r) << 24u) |
-           (uint(color.g) << 16u) |
-           (uint(color.b) << 8u)  |
-            uint(color.a);
-}
-
 void main()
 {
     float z = gl_FragCoord.z * gl_FragCoord.w;
-    
-    uint v = 1u << uint(32.0*z);
-    
-    fragColor = byteToColor(v);
+    uint layer = uint(float(slabWidth) * z);
+
+    /* On the far plane: first layer of the next slab, which draws it too */
+    if (layer >= slabWidth)
+        discard;
+
+    fragColor = uvec4(0u);
+    fragColor[layer / 32u] = 1u << (layer % 32u);
 }
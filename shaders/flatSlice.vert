@@ -6,8 +6,11 @@ uniform mat4 viewProjMatrix;
 
 layout(location = 0) in vec3 vPosition;
 
+flat out int instance; //always 0, see instancedSlice.vert
+
 
 void main(void)
 {
+    instance = gl_InstanceID;
     gl_Position = viewProjMatrix * modelMatrix * vec4(vPosition, 1);
 }
@@ -0,0 +1,47 @@
+#version 330
+
+
+/* Writes one slab of the result (32 Z-voxels per texel) into an R32UI texture, in the grid layout. */
+
+uniform usampler3D source;
+uniform uint nbChannels; //32 Z-voxels per channel of the source
+uniform bool sweep; //solid mode: turns the crossings parity into inside states
+uniform uint slice; //slab index
+
+out uint word;
+
+
+uint readWord(const ivec2 pixel, const uint slab)
+{
+    uvec4 texel = texelFetch(source, ivec3(pixel, int(slab / nbChannels)), 0);
+    return texel[slab % nbChannels];
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    uint v = readWord(pixel, slice);
+
+    if (sweep) {
+        /* Prefix-XOR inside the word */
+        v ^= v << 1u;
+        v ^= v << 2u;
+        v ^= v << 4u;
+        v ^= v << 8u;
+        v ^= v << 16u;
+
+        /* The column is inside at the bottom of the slab if the slabs below hold an odd number of crossings */
+        uint below = 0u;
+        for (uint s = 0u ; s < slice ; ++s)
+            below ^= readWord(pixel, s);
+        below ^= below >> 16u;
+        below ^= below >> 8u;
+        below ^= below >> 4u;
+        below ^= below >> 2u;
+        below ^= below >> 1u;
+        if ((below & 1u) != 0u)
+            v = ~v;
+    }
+
+    word = v;
+}
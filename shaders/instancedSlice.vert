@@ -0,0 +1,36 @@
+#version 430
+
+
+/* Same as flatSlice.vert and solidSlice.vert, for many grids at once (see Voxelizer::recomputeTransformed):
+ * each instance puts the mesh in the voxel coordinates of its own grid. */
+
+uniform samplerBuffer gridMatrices; //mesh to voxel coordinates, one column per texel
+uniform int firstInstance; //grid of the instance 0
+uniform bool solid;
+uniform vec2 viewportSize; //solid mode only: 1 pixel = 1 voxel
+
+layout(location = 0) in vec3 vPosition;
+
+flat out int instance; //grid in the drawn chunk
+out float layer; //solid mode only: depth in voxels from the grid start
+
+
+void main(void)
+{
+    int base = 4 * (firstInstance + gl_InstanceID);
+    mat4 gridMatrix = mat4(texelFetch(gridMatrices, base),
+                           texelFetch(gridMatrices, base + 1),
+                           texelFetch(gridMatrices, base + 2),
+                           texelFetch(gridMatrices, base + 3));
+    vec3 position = (gridMatrix * vec4(vPosition, 1)).xyz;
+
+    instance = gl_InstanceID;
+    layer = position.z;
+
+    /* Surface modes: voxel coordinates for dominantAxis.geom.
+     * Solid mode: Z projection, without near/far clipping (see solidSlice.vert). */
+    if (solid)
+        gl_Position = vec4(position.xy / viewportSize * 2.0 - 1.0, 0.0, 1.0);
+    else
+        gl_Position = vec4(position, 1);
+}
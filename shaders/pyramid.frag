@@ -0,0 +1,46 @@
+#version 330
+
+
+/* Writes one slab of a level of the occupancy pyramid, in the grid layout:
+ * each voxel is set if one of its 2x2x2 children of the finer level is (see CPUVoxelization::orReduce). */
+
+uniform usampler3D finer;
+uniform uvec3 finerSize; //in texels: (X, Y, Z/32 rounded up)
+uniform uint slice; //slab index
+
+out uint word;
+
+
+/* Bit i of the result is bit 2i OR bit 2i+1 of w */
+uint halveWord(uint w)
+{
+    w = (w | (w >> 1u)) & 0x55555555u;
+    w = (w | (w >> 1u)) & 0x33333333u;
+    w = (w | (w >> 2u)) & 0x0F0F0F0Fu;
+    w = (w | (w >> 4u)) & 0x00FF00FFu;
+    w = (w | (w >> 8u)) & 0x0000FFFFu;
+    return w;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    /* The low half comes from the finer slab 2*slice, the high half from the next one */
+    uint halves[2] = uint[](0u, 0u);
+    for (int iH = 0 ; iH < 2 ; ++iH) {
+        int slab = 2 * int(slice) + iH;
+        if (slab >= int(finerSize.z))
+            break;
+
+        for (int dy = 0 ; dy < 2 ; ++dy) {
+            for (int dx = 0 ; dx < 2 ; ++dx) {
+                ivec2 child = 2 * pixel + ivec2(dx, dy);
+                if (all(lessThan(child, ivec2(finerSize.xy))))
+                    halves[iH] |= texelFetch(finer, ivec3(child, slab), 0).r;
+            }
+        }
+    }
+
+    word = halveWord(halves[0]) | (halveWord(halves[1]) << 16u);
+}
@@ -0,0 +1,24 @@
+#version 430
+
+
+/* Same as solidSlice.frag, but the whole grid depth is handled at once
+ * and the crossing is directly flipped in the grid. */
+
+layout(r32ui, binding = 0) uniform uimage3D grid; //(X, Y, Z/32), bit Z%32, grids stacked along the depth
+
+uniform float nbLayers;
+uniform uint slabsPerGrid; //only needed with several grids
+
+flat in int instance;
+in float layer;
+
+
+void main()
+{
+    /* First voxel whose center is above the surface, crossings below the grid flip the whole column */
+    int bit = int(max(floor(layer + 0.5), 0.0));
+    if (bit >= int(nbLayers))
+        discard;
+
+    imageAtomicXor(grid, ivec3(ivec2(gl_FragCoord.xy), bit / 32 + instance * int(slabsPerGrid)), 1u << uint(bit % 32));
+}
@@ -0,0 +1,22 @@
+#version 330
+
+
+uniform uint firstLayer; //first layer of the current slab
+uniform uint slabWidth; //layers per texel: 32 per channel of the target
+
+in float layer;
+
+out uvec4 fragColor;
+
+
+void main()
+{
+    /* First voxel whose center is above the surface, crossings below the grid flip the whole column */
+    float bit = max(floor(layer + 0.5), 0.0) - float(firstLayer);
+    if (bit < 0.0 || bit >= float(slabWidth))
+        discard;
+
+    uint i = uint(bit);
+    fragColor = uvec4(0u);
+    fragColor[i / 32u] = 1u << (i % 32u);
+}
@@ -0,0 +1,23 @@
+#version 330
+
+
+uniform mat4 modelMatrix;
+uniform mat4 viewProjMatrix; //near and far planes enclose the whole grid
+
+uniform float nbLayers;
+
+layout(location = 0) in vec3 vPosition;
+
+flat out int instance; //always 0, see instancedSlice.vert
+out float layer; //depth in voxels from the grid start
+
+
+void main(void)
+{
+    instance = gl_InstanceID;
+    vec4 position = viewProjMatrix * modelMatrix * vec4(vPosition, 1);
+    layer = (position.z / position.w * 0.5 + 0.5) * nbLayers;
+
+    /* No near/far clipping: every pass rasterizes the exact same fragments */
+    gl_Position = vec4(position.xy, 0.0, position.w);
+}
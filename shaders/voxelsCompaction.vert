@@ -0,0 +1,20 @@
+#version 330
+
+
+/* One vertex per word of the grid texture (32 Z-voxels), in the grid layout order. */
+
+uniform usampler3D grid;
+uniform ivec3 gridSize; //in words
+
+flat out uint word;
+flat out ivec3 wordCoords;
+
+
+void main()
+{
+    int nbWordsXY = gridSize.x * gridSize.y;
+    wordCoords = ivec3(gl_VertexID % gridSize.x, (gl_VertexID % nbWordsXY) / gridSize.x, gl_VertexID / nbWordsXY);
+    word = texelFetch(grid, wordCoords, 0).r;
+
+    gl_Position = vec4(0, 0, 0, 1);
+}
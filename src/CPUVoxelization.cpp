@@ -0,0 +1,347 @@
+#include "CPUVoxelization.hpp"
+
+
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+
+static const unsigned int BRICK_ROWS = 32;
+
+/* Range of the voxels [i,i+1] overlapping [minCoord,maxCoord], clamped to [offset,offset+n-1].
+ * @return false if empty */
+static bool voxelRange(float minCoord, float maxCoord, unsigned int offset, unsigned int n, unsigned int& first, unsigned int& last)
+{
+    const float lowest = std::max((float)offset, std::ceil(minCoord) - 1.f);
+    const float highest = std::min((float)(offset + n) - 1.f, std::floor(maxCoord));
+    if (lowest > highest)
+        return false;
+
+    first = (unsigned int)lowest;
+    last = (unsigned int)highest;
+    return true;
+}
+
+/* Range of the columns whose center i+0.5 is in [minCoord,maxCoord], clamped to [offset,offset+n-1].
+ * @return false if empty */
+static bool centerRange(float minCoord, float maxCoord, unsigned int offset, unsigned int n, unsigned int& first, unsigned int& last)
+{
+    const float lowest = std::max((float)offset, std::ceil(minCoord - 0.5f));
+    const float highest = std::min((float)(offset + n) - 1.f, std::floor(maxCoord - 0.5f));
+    if (lowest > highest)
+        return false;
+
+    first = (unsigned int)lowest;
+    last = (unsigned int)highest;
+    return true;
+}
+
+/* Signed area of (a,b,p) in the XY plane. The endpoints are sorted first, so that
+ * the two triangles sharing an edge get exactly opposite values whatever their winding. */
+static float edgeFunction(glm::vec3 a, glm::vec3 b, float px, float py)
+{
+    const bool swapped = (b.x < a.x) || (b.x == a.x && b.y < a.y);
+    if (swapped)
+        std::swap(a, b);
+    const float e = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    return swapped ? -e : e;
+}
+
+static void runWorkers(unsigned int nbThreads, unsigned int nbTasks, std::function<void()> const& worker)
+{
+    if (nbThreads == 0)
+        nbThreads = std::max(1u, std::thread::hardware_concurrency());
+    nbThreads = std::min(nbThreads, nbTasks);
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1 ; i < nbThreads ; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+CPUVoxelization::TriangleBoxTest::TriangleBoxTest(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2,
+                                                  Separability separability)
+{
+    const glm::vec3 edges[3] = {v1 - v0, v2 - v1, v0 - v2};
+    const glm::vec3 units[3] = {glm::vec3(1,0,0), glm::vec3(0,1,0), glm::vec3(0,0,1)};
+
+    /* Box normals, triangle normal, then the 9 edge/box-edge cross products */
+    unsigned int iA = 0;
+    for (unsigned int i = 0 ; i < 3 ; ++i)
+        axes[iA++] = units[i];
+    axes[iA++] = glm::cross(edges[0], edges[1]);
+    for (unsigned int iE = 0 ; iE < 3 ; ++iE) {
+        for (unsigned int iU = 0 ; iU < 3 ; ++iU)
+            axes[iA++] = glm::cross(edges[iE], units[iU]);
+    }
+
+    for (unsigned int i = 0 ; i < 13 ; ++i) {
+        const glm::vec3& a = axes[i];
+        const float p0 = glm::dot(a, v0);
+        const float p1 = glm::dot(a, v1);
+        const float p2 = glm::dot(a, v2);
+        float radius = 0.5f * (std::abs(a.x) + std::abs(a.y) + std::abs(a.z));
+        if (i == 3 && separability == Separability::TwentySix)
+            radius = 0.5f * std::max(std::abs(a.x), std::max(std::abs(a.y), std::abs(a.z)));
+
+        lo[i] = std::min(p0, std::min(p1, p2)) - radius;
+        hi[i] = std::max(p0, std::max(p1, p2)) + radius;
+    }
+
+    minCoords = glm::min(v0, glm::min(v1, v2));
+    maxCoords = glm::max(v0, glm::max(v1, v2));
+}
+
+bool CPUVoxelization::TriangleBoxTest::overlaps(unsigned int iX, unsigned int iY, unsigned int iZ) const
+{
+    const glm::vec3 center = glm::vec3(iX, iY, iZ) + glm::vec3(0.5f);
+    for (unsigned int i = 0 ; i < 13 ; ++i) {
+        const float d = glm::dot(axes[i], center);
+        if (d < lo[i] || d > hi[i])
+            return false;
+    }
+    return true;
+}
+
+void CPUVoxelization::voxelize(std::vector<glm::vec3> const& vertices,
+                               std::vector<glm::ivec3> const& triangles,
+                               glm::vec3 const& minCorner,
+                               float voxelSize,
+                               glm::uvec3 const& nbVoxels,
+                               glm::uvec3 const& firstVoxel,
+                               std::vector<uint32_t>& grid,
+                               Separability separability,
+                               unsigned int nbThreads,
+                               ISA isa)
+{
+    if (nbVoxels.x == 0 || nbVoxels.y == 0 || nbVoxels.z == 0)
+        return;
+
+    if (isa == ISA::Auto || !isSupported(isa))
+        isa = detectISA();
+    const ColumnKernel kernel = columnKernel(isa);
+
+    const unsigned int nbSlabs = nbVoxels.z / 32;
+    const unsigned int nbBands = (nbVoxels.y + BRICK_ROWS - 1) / BRICK_ROWS;
+
+    /* Triangles preparation, in voxel units of the whole grid */
+    std::vector<TriangleBoxTest> tests;
+    tests.reserve(triangles.size());
+    for (glm::ivec3 const& t : triangles) {
+        tests.emplace_back((vertices[t.x] - minCorner) / voxelSize,
+                           (vertices[t.y] - minCorner) / voxelSize,
+                           (vertices[t.z] - minCorner) / voxelSize,
+                           separability);
+    }
+
+    /* Binning: each brick gets the list of the triangles whose bounding box overlaps it */
+    std::vector<std::vector<unsigned int>> bins(nbSlabs * nbBands);
+    for (std::size_t iT = 0 ; iT < tests.size() ; ++iT) {
+        TriangleBoxTest const& test = tests[iT];
+        unsigned int firstY, lastY, firstZ, lastZ, firstX, lastX;
+        if (!voxelRange(test.minCoords.x, test.maxCoords.x, firstVoxel.x, nbVoxels.x, firstX, lastX) ||
+            !voxelRange(test.minCoords.y, test.maxCoords.y, firstVoxel.y, nbVoxels.y, firstY, lastY) ||
+            !voxelRange(test.minCoords.z, test.maxCoords.z, firstVoxel.z, nbVoxels.z, firstZ, lastZ))
+            continue;
+
+        for (unsigned int iS = (firstZ - firstVoxel.z) / 32 ; iS <= (lastZ - firstVoxel.z) / 32 ; ++iS) {
+            for (unsigned int iB = (firstY - firstVoxel.y) / BRICK_ROWS ; iB <= (lastY - firstVoxel.y) / BRICK_ROWS ; ++iB)
+                bins[iS * nbBands + iB].push_back(iT);
+        }
+    }
+
+    /* Each brick writes its own words only */
+    std::atomic<unsigned int> nextBrick(0);
+    auto worker = [&]() {
+        for (unsigned int iBrick = nextBrick++ ; iBrick < bins.size() ; iBrick = nextBrick++) {
+            const unsigned int slab = iBrick / nbBands;
+            const unsigned int band = iBrick % nbBands;
+            const unsigned int brickFirstY = firstVoxel.y + band * BRICK_ROWS;
+            const unsigned int brickLastY = firstVoxel.y + std::min(nbVoxels.y, band * BRICK_ROWS + BRICK_ROWS) - 1;
+            const unsigned int slabFirstZ = firstVoxel.z + 32 * slab;
+
+            for (unsigned int iT : bins[iBrick]) {
+                TriangleBoxTest const& test = tests[iT];
+                unsigned int firstX, lastX, firstY, lastY, firstZ, lastZ;
+                voxelRange(test.minCoords.x, test.maxCoords.x, firstVoxel.x, nbVoxels.x, firstX, lastX);
+                voxelRange(test.minCoords.y, test.maxCoords.y, firstVoxel.y, nbVoxels.y, firstY, lastY);
+                voxelRange(test.minCoords.z, test.maxCoords.z, firstVoxel.z, nbVoxels.z, firstZ, lastZ);
+                firstY = std::max(firstY, brickFirstY);
+                lastY = std::min(lastY, brickLastY);
+                firstZ = std::max(firstZ, slabFirstZ);
+                lastZ = std::min(lastZ, slabFirstZ + 31);
+
+                /* The kernels take the voxels of the whole grid, the words are those of the part */
+                for (unsigned int iY = firstY ; iY <= lastY ; ++iY) {
+                    uint32_t* row = grid.data() + ((std::size_t)slab * nbVoxels.y + iY - firstVoxel.y) * nbVoxels.x;
+                    for (unsigned int iX = firstX ; iX <= lastX ; ++iX)
+                        row[iX - firstVoxel.x] |= kernel(test, iX, iY, firstZ, lastZ);
+                }
+            }
+        }
+    };
+
+    runWorkers(nbThreads, bins.size(), worker);
+}
+
+void CPUVoxelization::voxelizeSolid(std::vector<glm::vec3> const& vertices,
+                                    std::vector<glm::ivec3> const& triangles,
+                                    glm::vec3 const& minCorner,
+                                    float voxelSize,
+                                    glm::uvec3 const& nbVoxels,
+                                    glm::uvec3 const& firstVoxel,
+                                    std::vector<uint32_t>& grid,
+                                    unsigned int nbThreads)
+{
+    if (nbVoxels.x == 0 || nbVoxels.y == 0 || nbVoxels.z == 0)
+        return;
+
+    const unsigned int nbBands = (nbVoxels.y + BRICK_ROWS - 1) / BRICK_ROWS;
+    const std::size_t slabSize = (std::size_t)nbVoxels.x * nbVoxels.y;
+
+    /* Binning by bands of rows: a column's flips may land in any slab */
+    std::vector<glm::vec3> points(vertices.size());
+    for (std::size_t i = 0 ; i < vertices.size() ; ++i)
+        points[i] = (vertices[i] - minCorner) / voxelSize;
+
+    std::vector<std::vector<unsigned int>> bins(nbBands);
+    for (std::size_t iT = 0 ; iT < triangles.size() ; ++iT) {
+        glm::ivec3 const& t = triangles[iT];
+        const float minY = std::min(points[t.x].y, std::min(points[t.y].y, points[t.z].y));
+        const float maxY = std::max(points[t.x].y, std::max(points[t.y].y, points[t.z].y));
+        unsigned int firstY, lastY;
+        if (!centerRange(minY, maxY, firstVoxel.y, nbVoxels.y, firstY, lastY))
+            continue;
+
+        for (unsigned int iB = (firstY - firstVoxel.y) / BRICK_ROWS ; iB <= (lastY - firstVoxel.y) / BRICK_ROWS ; ++iB)
+            bins[iB].push_back(iT);
+    }
+
+    std::atomic<unsigned int> nextBand(0);
+    auto worker = [&]() {
+        for (unsigned int band = nextBand++ ; band < nbBands ; band = nextBand++) {
+            const unsigned int bandFirstY = firstVoxel.y + band * BRICK_ROWS;
+            const unsigned int bandLastY = firstVoxel.y + std::min(nbVoxels.y, band * BRICK_ROWS + BRICK_ROWS) - 1;
+
+            for (unsigned int iT : bins[band]) {
+                const glm::vec3 v[3] = {points[triangles[iT].x], points[triangles[iT].y], points[triangles[iT].z]};
+                const glm::vec3 n = glm::cross(v[1] - v[0], v[2] - v[0]);
+                if (n.z == 0.f)
+                    continue; //parallel to Z, never crossed
+
+                /* For each edge, the side of the triangle's inside. On the edge itself,
+                 * only the triangle lying on the positive side counts the crossing. */
+                float insideSigns[3];
+                for (unsigned int iE = 0 ; iE < 3 ; ++iE) {
+                    const glm::vec3& opposite = v[(iE + 2) % 3];
+                    insideSigns[iE] = (edgeFunction(v[iE], v[(iE + 1) % 3], opposite.x, opposite.y) > 0.f) ? 1.f : -1.f;
+                }
+
+                const glm::vec3 minCoords = glm::min(v[0], glm::min(v[1], v[2]));
+                const glm::vec3 maxCoords = glm::max(v[0], glm::max(v[1], v[2]));
+                unsigned int firstX, lastX, firstY, lastY;
+                if (!centerRange(minCoords.x, maxCoords.x, firstVoxel.x, nbVoxels.x, firstX, lastX) ||
+                    !centerRange(minCoords.y, maxCoords.y, firstVoxel.y, nbVoxels.y, firstY, lastY))
+                    continue;
+                firstY = std::max(firstY, bandFirstY);
+                lastY = std::min(lastY, bandLastY);
+
+                for (unsigned int iY = firstY ; iY <= lastY ; ++iY) {
+                    const float cy = (float)iY + 0.5f;
+                    for (unsigned int iX = firstX ; iX <= lastX ; ++iX) {
+                        const float cx = (float)iX + 0.5f;
+
+                        bool inside = true;
+                        for (unsigned int iE = 0 ; iE < 3 && inside ; ++iE) {
+                            const float e = insideSigns[iE] * edgeFunction(v[iE], v[(iE + 1) % 3], cx, cy);
+                            inside = (e > 0.f) || (e == 0.f && insideSigns[iE] > 0.f);
+                        }
+                        if (!inside)
+                            continue;
+
+                        /* First voxel whose center is above the crossing point, the crossings below the part
+                         * flipping its first voxel so that the parity of the column is kept */
+                        const float z = v[0].z - (n.x * (cx - v[0].x) + n.y * (cy - v[0].y)) / n.z;
+                        const float k = std::max(0.f, std::floor(z + 0.5f) - (float)firstVoxel.z);
+                        if (k >= (float)nbVoxels.z)
+                            continue;
+
+                        const unsigned int iZ = (unsigned int)k;
+                        grid[(iZ / 32) * slabSize + (std::size_t)(iY - firstVoxel.y) * nbVoxels.x + iX - firstVoxel.x] ^= 1u << (iZ % 32);
+                    }
+                }
+            }
+        }
+    };
+
+    runWorkers(nbThreads, nbBands, worker);
+
+    prefixXorSweep(nbVoxels, grid);
+}
+
+void CPUVoxelization::prefixXorSweep(glm::uvec3 const& nbVoxels, std::vector<uint32_t>& grid)
+{
+    const std::size_t slabSize = (std::size_t)nbVoxels.x * nbVoxels.y;
+    const unsigned int nbSlabs = nbVoxels.z / 32;
+
+    std::vector<uint32_t> carries(slabSize, 0u);
+    for (unsigned int iS = 0 ; iS < nbSlabs ; ++iS)
+        prefixXorSweepSlab(grid.data() + iS * slabSize, carries.data(), slabSize);
+}
+
+void CPUVoxelization::prefixXorSweepSlab(uint32_t* slab, uint32_t* carries, std::size_t nbWords)
+{
+    for (std::size_t i = 0 ; i < nbWords ; ++i) {
+        uint32_t word = slab[i];
+        word ^= word << 1;
+        word ^= word << 2;
+        word ^= word << 4;
+        word ^= word << 8;
+        word ^= word << 16;
+        word ^= carries[i];
+
+        slab[i] = word;
+        carries[i] = 0u - (word >> 31);
+    }
+}
+
+/* Bit i of the result is bit 2i OR bit 2i+1 of the word: 32 voxels along Z become 16 */
+static inline uint32_t halveWord(uint32_t word)
+{
+    word = (word | (word >> 1)) & 0x55555555u;
+    word = (word | (word >> 1)) & 0x33333333u;
+    word = (word | (word >> 2)) & 0x0F0F0F0Fu;
+    word = (word | (word >> 4)) & 0x00FF00FFu;
+    word = (word | (word >> 8)) & 0x0000FFFFu;
+    return word;
+}
+
+void CPUVoxelization::orReduce(glm::uvec3 const& nbVoxels, std::vector<uint32_t> const& grid,
+                               glm::uvec3& reducedSize, std::vector<uint32_t>& reduced)
+{
+    reducedSize = (nbVoxels + 1u) / 2u;
+    const unsigned int nbSlabs = (nbVoxels.z + 31) / 32;
+    const unsigned int nbReducedSlabs = (reducedSize.z + 31) / 32;
+    reduced.assign((std::size_t)reducedSize.x * reducedSize.y * nbReducedSlabs, 0u);
+
+    /* Each reduced slab gets the low half from the slab 2*iS and the high half from the slab 2*iS+1,
+     * each reduced row ORs two rows, each reduced word two consecutive words */
+    const unsigned int nbPairs = nbVoxels.x / 2;
+    for (unsigned int iS = 0 ; iS < nbReducedSlabs ; ++iS) {
+        for (unsigned int iH = 0 ; iH < 2 && 2 * iS + iH < nbSlabs ; ++iH) {
+            const unsigned int shift = 16 * iH;
+            for (unsigned int iY = 0 ; iY < nbVoxels.y ; ++iY) {
+                uint32_t const* row = grid.data() + ((std::size_t)(2 * iS + iH) * nbVoxels.y + iY) * nbVoxels.x;
+                uint32_t* reducedRow = reduced.data() + ((std::size_t)iS * reducedSize.y + iY / 2) * reducedSize.x;
+                for (unsigned int iX = 0 ; iX < nbPairs ; ++iX)
+                    reducedRow[iX] |= halveWord(row[2 * iX] | row[2 * iX + 1]) << shift;
+                if (nbVoxels.x % 2 != 0)
+                    reducedRow[nbPairs] |= halveWord(row[2 * nbPairs]) << shift;
+            }
+        }
+    }
+}
@@ -0,0 +1,200 @@
+#include "CPUVoxelization.hpp"
+
+
+/* Column kernels: occupancy word of 32 Z-voxels against one triangle.
+ *
+ * For every axis a, dot(a, center) = (a.x*cx + a.y*cy) + a.z*cz, where only cz changes along the column.
+ * The SIMD variants evaluate this expression with the same operations, in the same order,
+ * as TriangleBoxTest::overlaps, so they are bit exact with the scalar version.
+ * Only the vectors covering [firstZ,lastZ] are evaluated, the lanes outside the range are masked out. */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define CPUVOXELIZATION_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+/* AVX-512 implies FMA: fused multiply-adds would round differently from the scalar version */
+#if defined(__clang__)
+    #pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+    #pragma GCC optimize ("fp-contract=off")
+#endif
+
+
+/* Bits firstZ%32 to lastZ%32 */
+static inline uint32_t rangeMask(unsigned int firstZ, unsigned int lastZ)
+{
+    const uint32_t upTo = (lastZ % 32 == 31) ? 0xFFFFFFFFu : (1u << (lastZ % 32 + 1)) - 1u;
+    return upTo & ~((1u << (firstZ % 32)) - 1u);
+}
+
+static uint32_t columnScalar(CPUVoxelization::TriangleBoxTest const& test,
+                             unsigned int iX, unsigned int iY,
+                             unsigned int firstZ, unsigned int lastZ)
+{
+    uint32_t word = 0u;
+    for (unsigned int iZ = firstZ ; iZ <= lastZ ; ++iZ) {
+        if (test.overlaps(iX, iY, iZ))
+            word |= 1u << (iZ % 32);
+    }
+    return word;
+}
+
+#ifdef CPUVOXELIZATION_X86_KERNELS
+
+__attribute__((target("sse4.2")))
+static uint32_t columnSSE42(CPUVoxelization::TriangleBoxTest const& test,
+                            unsigned int iX, unsigned int iY,
+                            unsigned int firstZ, unsigned int lastZ)
+{
+    const float cx = (float)iX + 0.5f;
+    const float cy = (float)iY + 0.5f;
+    const unsigned int slabFirstZ = firstZ & ~31u;
+
+    float bases[13];
+    for (unsigned int i = 0 ; i < 13 ; ++i)
+        bases[i] = test.axes[i].x * cx + test.axes[i].y * cy;
+
+    uint32_t word = 0u;
+    for (unsigned int lane = (firstZ % 32) & ~3u ; lane <= lastZ % 32 ; lane += 4) {
+        const __m128i iZ = _mm_add_epi32(_mm_set1_epi32(slabFirstZ + lane), _mm_setr_epi32(0, 1, 2, 3));
+        const __m128 cz = _mm_add_ps(_mm_cvtepi32_ps(iZ), _mm_set1_ps(0.5f));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (unsigned int i = 0 ; i < 13 ; ++i) {
+            const __m128 d = _mm_add_ps(_mm_set1_ps(bases[i]), _mm_mul_ps(_mm_set1_ps(test.axes[i].z), cz));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_set1_ps(test.lo[i])));
+            inside = _mm_and_ps(inside, _mm_cmple_ps(d, _mm_set1_ps(test.hi[i])));
+        }
+        word |= (uint32_t)_mm_movemask_ps(inside) << lane;
+    }
+    return word & rangeMask(firstZ, lastZ);
+}
+
+__attribute__((target("avx2")))
+static uint32_t columnAVX2(CPUVoxelization::TriangleBoxTest const& test,
+                           unsigned int iX, unsigned int iY,
+                           unsigned int firstZ, unsigned int lastZ)
+{
+    const float cx = (float)iX + 0.5f;
+    const float cy = (float)iY + 0.5f;
+    const unsigned int slabFirstZ = firstZ & ~31u;
+
+    float bases[13];
+    for (unsigned int i = 0 ; i < 13 ; ++i)
+        bases[i] = test.axes[i].x * cx + test.axes[i].y * cy;
+
+    uint32_t word = 0u;
+    for (unsigned int lane = (firstZ % 32) & ~7u ; lane <= lastZ % 32 ; lane += 8) {
+        const __m256i iZ = _mm256_add_epi32(_mm256_set1_epi32(slabFirstZ + lane), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        const __m256 cz = _mm256_add_ps(_mm256_cvtepi32_ps(iZ), _mm256_set1_ps(0.5f));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (unsigned int i = 0 ; i < 13 ; ++i) {
+            const __m256 d = _mm256_add_ps(_mm256_set1_ps(bases[i]), _mm256_mul_ps(_mm256_set1_ps(test.axes[i].z), cz));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_set1_ps(test.lo[i]), _CMP_GE_OQ));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_set1_ps(test.hi[i]), _CMP_LE_OQ));
+        }
+        word |= (uint32_t)_mm256_movemask_ps(inside) << lane;
+    }
+    return word & rangeMask(firstZ, lastZ);
+}
+
+__attribute__((target("avx512f")))
+static uint32_t columnAVX512(CPUVoxelization::TriangleBoxTest const& test,
+                             unsigned int iX, unsigned int iY,
+                             unsigned int firstZ, unsigned int lastZ)
+{
+    const float cx = (float)iX + 0.5f;
+    const float cy = (float)iY + 0.5f;
+    const unsigned int slabFirstZ = firstZ & ~31u;
+
+    float bases[13];
+    for (unsigned int i = 0 ; i < 13 ; ++i)
+        bases[i] = test.axes[i].x * cx + test.axes[i].y * cy;
+
+    uint32_t word = 0u;
+    for (unsigned int lane = (firstZ % 32) & ~15u ; lane <= lastZ % 32 ; lane += 16) {
+        const __m512i iZ = _mm512_add_epi32(_mm512_set1_epi32(slabFirstZ + lane),
+                                            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        const __m512 cz = _mm512_add_ps(_mm512_maskz_cvtepi32_ps(0xFFFF, iZ), _mm512_set1_ps(0.5f));
+
+        __mmask16 inside = 0xFFFF;
+        for (unsigned int i = 0 ; i < 13 && inside ; ++i) {
+            const __m512 d = _mm512_add_ps(_mm512_set1_ps(bases[i]), _mm512_mul_ps(_mm512_set1_ps(test.axes[i].z), cz));
+            inside = _mm512_mask_cmp_ps_mask(inside, d, _mm512_set1_ps(test.lo[i]), _CMP_GE_OQ);
+            inside = _mm512_mask_cmp_ps_mask(inside, d, _mm512_set1_ps(test.hi[i]), _CMP_LE_OQ);
+        }
+        word |= (uint32_t)inside << lane;
+    }
+    return word & rangeMask(firstZ, lastZ);
+}
+
+#endif // CPUVOXELIZATION_X86_KERNELS
+
+bool CPUVoxelization::isSupported(ISA isa)
+{
+    switch (isa) {
+        case ISA::Auto:
+        case ISA::Scalar:
+            return true;
+#ifdef CPUVOXELIZATION_X86_KERNELS
+        case ISA::SSE42:
+            return __builtin_cpu_supports("sse4.2");
+        case ISA::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case ISA::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+CPUVoxelization::ISA CPUVoxelization::detectISA()
+{
+    const ISA preferred[] = {ISA::AVX512, ISA::AVX2, ISA::SSE42};
+    for (ISA isa : preferred) {
+        if (isSupported(isa))
+            return isa;
+    }
+    return ISA::Scalar;
+}
+
+const char* CPUVoxelization::isaName(ISA isa)
+{
+    switch (isa) {
+        case ISA::Auto:
+            return "auto";
+        case ISA::Scalar:
+            return "scalar";
+        case ISA::SSE42:
+            return "sse4.2";
+        case ISA::AVX2:
+            return "avx2";
+        case ISA::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+CPUVoxelization::ColumnKernel CPUVoxelization::columnKernel(ISA isa)
+{
+    if (isa == ISA::Auto)
+        isa = detectISA();
+    if (!isSupported(isa))
+        return nullptr;
+
+    switch (isa) {
+#ifdef CPUVOXELIZATION_X86_KERNELS
+        case ISA::SSE42:
+            return &columnSSE42;
+        case ISA::AVX2:
+            return &columnAVX2;
+        case ISA::AVX512:
+            return &columnAVX512;
+#endif
+        default:
+            return &columnScalar;
+    }
+}
@@ -0,0 +1,157 @@
+#include "HeadlessContext.hpp"
+
+
+#include <iostream>
+#include <sstream>
+
+#include <GL/glew.h>
+
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+
+static bool initGLEW()
+{
+    glewExperimental = GL_TRUE;
+    GLenum err = glewInit();
+
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    /* Without X server there is no GLX display, but the core entry points are loaded anyway */
+    if (err == GLEW_ERROR_NO_GLX_DISPLAY)
+        err = GLEW_OK;
+#endif
+
+    if (GLEW_OK != err) {
+        std::cerr << "Error while initializing GLEW: " << glewGetErrorString(err) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+HeadlessContext::HeadlessContext(unsigned int majorVersion, unsigned int minorVersion):
+            _display(EGL_NO_DISPLAY),
+            _surface(EGL_NO_SURFACE),
+            _context(EGL_NO_CONTEXT),
+            _valid(false)
+{
+    /* Surfaceless platform first: it needs neither X server nor DRM device */
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY)
+            _valid = create(display, false, majorVersion, minorVersion);
+    }
+
+    if (!_valid) {
+        EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display != EGL_NO_DISPLAY)
+            _valid = create(display, true, majorVersion, minorVersion);
+    }
+
+    if (!_valid) {
+        std::cerr << "Error: couldn't create an offscreen OpenGL " << majorVersion << "." << minorVersion << " core context." << std::endl;
+        return;
+    }
+
+    _valid = initGLEW();
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    destroy();
+}
+
+bool HeadlessContext::create(void* display, bool usePbuffer, unsigned int majorVersion, unsigned int minorVersion)
+{
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor))
+        return false;
+
+    _display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        destroy();
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, usePbuffer ? EGL_PBUFFER_BIT : 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint nbConfigs = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &nbConfigs) || nbConfigs == 0) {
+        if (usePbuffer) {
+            destroy();
+            return false;
+        }
+        config = nullptr; //EGL_KHR_no_config_context
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, (EGLint)majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, (EGLint)minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    _context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (_context == EGL_NO_CONTEXT) {
+        destroy();
+        return false;
+    }
+
+    if (usePbuffer) {
+        const EGLint pbufferAttribs[] = {
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+        };
+        _surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+        if (_surface == EGL_NO_SURFACE) {
+            destroy();
+            return false;
+        }
+    }
+
+    if (!eglMakeCurrent(display, _surface, _surface, _context)) {
+        destroy();
+        return false;
+    }
+
+    return true;
+}
+
+void HeadlessContext::destroy()
+{
+    if (_display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (_surface != EGL_NO_SURFACE)
+        eglDestroySurface(_display, _surface);
+    if (_context != EGL_NO_CONTEXT)
+        eglDestroyContext(_display, _context);
+    eglTerminate(_display);
+
+    _display = EGL_NO_DISPLAY;
+    _surface = EGL_NO_SURFACE;
+    _context = EGL_NO_CONTEXT;
+}
+
+bool HeadlessContext::isValid() const
+{
+    return _valid;
+}
+
+std::string HeadlessContext::description() const
+{
+    if (!_valid)
+        return std::string();
+
+    std::stringstream ss;
+    ss << glGetString(GL_VERSION) << " / " << glGetString(GL_RENDERER);
+    return ss.str();
+}
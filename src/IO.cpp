@@ -2,6 +2,9 @@
 
 
 #include <iostream>
+#include <fstream>
+#include <limits>
+#include <cstring>
 
 #define TINYOBJLOADER_IMPLEMENTATION // define this in only *one* .cc
 #include "tiny_obj_loader.h"
@@ -116,3 +119,279 @@ bool IO::readObj(std::string const& filename,
 
     return true;
 }
+
+bool IO::readObj(std::string const& filename,
+                 std::vector<glm::vec3>& vertices,
+                 std::vector<glm::ivec3>& triangles,
+                 std::vector<int>& triangleMaterials,
+                 std::vector<Material>& materials)
+{
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> objMaterials;
+    std::string err;
+
+    const std::size_t slash = filename.find_last_of("/\\");
+    const std::string directory = (slash == std::string::npos) ? "" : filename.substr(0, slash + 1);
+
+    if (!tinyobj::LoadObj(shapes, objMaterials, err, filename.c_str(), directory.c_str())) {
+        std::cerr << "Error: couldn't load " << filename << " : " << err << std::endl;
+        return false;
+    }
+
+    if (!err.empty())
+        std::cerr << "Error: while loading " << filename << " : " << err << std::endl;
+
+    vertices.clear();
+    triangles.clear();
+    triangleMaterials.clear();
+    for (tinyobj::shape_t const& shape : shapes) {
+        if (shape.mesh.indices.size() % 3 != 0) {
+            std::cerr << "Warning: in " << filename << ", mesh " << shape.name << " is not triangulated and won't be loaded." << std::endl;
+            continue;
+        }
+
+        if (shape.mesh.positions.size() % 3 != 0) {
+            std::cerr << "Warning: in " << filename << ", some positions are incorrect. The mesh won't be loaded." << std::endl;
+            continue;
+        }
+
+        const int firstVertex = vertices.size();
+        const std::size_t nbTriangles = shape.mesh.indices.size() / 3;
+        const std::size_t nbVertices = shape.mesh.positions.size() / 3;
+
+        for (std::size_t iT = 0 ; iT < nbTriangles ; ++iT) {
+            triangles.push_back(glm::ivec3(firstVertex + shape.mesh.indices[3*iT + 0],
+                                           firstVertex + shape.mesh.indices[3*iT + 1],
+                                           firstVertex + shape.mesh.indices[3*iT + 2]));
+
+            int material = (iT < shape.mesh.material_ids.size()) ? shape.mesh.material_ids[iT] : -1;
+            if (material >= (int)objMaterials.size())
+                material = -1;
+            triangleMaterials.push_back(material);
+        }
+
+        for (std::size_t iV = 0 ; iV < nbVertices ; ++iV) {
+            vertices.push_back(glm::vec3(shape.mesh.positions[3*iV + 0],
+                                         shape.mesh.positions[3*iV + 1],
+                                         shape.mesh.positions[3*iV + 2]));
+        }
+    }
+
+    materials.resize(objMaterials.size());
+    for (std::size_t iM = 0 ; iM < objMaterials.size() ; ++iM) {
+        materials[iM].name = objMaterials[iM].name;
+        materials[iM].diffuse = glm::vec3(objMaterials[iM].diffuse[0], objMaterials[iM].diffuse[1], objMaterials[iM].diffuse[2]);
+        materials[iM].diffuseTexture = objMaterials[iM].diffuse_texname;
+    }
+
+    return true;
+}
+
+static void writeHeader(std::ostream& file, glm::uvec3 const& nbVoxels, glm::vec3 const& minCorner, float voxelSize)
+{
+    file.precision(std::numeric_limits<float>::max_digits10);
+    file << "VOXELS 1\n";
+    file << nbVoxels.x << " " << nbVoxels.y << " " << nbVoxels.z << "\n";
+    file << minCorner.x << " " << minCorner.y << " " << minCorner.z << "\n";
+    file << voxelSize << "\n";
+}
+
+/* Words are written byte by byte so the file doesn't depend on the host endianness */
+static void toLittleEndian(uint32_t const* words, std::size_t nbWords, std::vector<char>& bytes)
+{
+    bytes.resize(4 * nbWords);
+    for (std::size_t i = 0 ; i < nbWords ; ++i) {
+        bytes[4*i + 0] = (char)(words[i] & 0xFFu);
+        bytes[4*i + 1] = (char)((words[i] >> 8) & 0xFFu);
+        bytes[4*i + 2] = (char)((words[i] >> 16) & 0xFFu);
+        bytes[4*i + 3] = (char)((words[i] >> 24) & 0xFFu);
+    }
+}
+
+bool IO::writeVoxels(std::string const& filename,
+                     glm::uvec3 const& nbVoxels,
+                     glm::vec3 const& minCorner,
+                     float voxelSize,
+                     std::vector<uint32_t> const& grid)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: couldn't open " << filename << " for writing." << std::endl;
+        return false;
+    }
+
+    writeHeader(file, nbVoxels, minCorner, voxelSize);
+
+    std::vector<char> bytes;
+    toLittleEndian(grid.data(), grid.size(), bytes);
+    file.write(bytes.data(), bytes.size());
+
+    if (!file.good()) {
+        std::cerr << "Error: couldn't write " << filename << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IO::writeCoverage(std::string const& filename,
+                       glm::uvec3 const& nbVoxels,
+                       glm::vec3 const& minCorner,
+                       float voxelSize,
+                       unsigned int bitsPerVoxel,
+                       std::vector<uint8_t> const& coverage)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: couldn't open " << filename << " for writing." << std::endl;
+        return false;
+    }
+
+    file.precision(std::numeric_limits<float>::max_digits10);
+    file << "COVERAGE " << bitsPerVoxel << "\n";
+    file << nbVoxels.x << " " << nbVoxels.y << " " << nbVoxels.z << "\n";
+    file << minCorner.x << " " << minCorner.y << " " << minCorner.z << "\n";
+    file << voxelSize << "\n";
+    file.write((char const*)coverage.data(), coverage.size());
+
+    if (!file.good()) {
+        std::cerr << "Error: couldn't write " << filename << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IO::writeSparseVoxels(std::string const& filename, SparseGrid const& sparse)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: couldn't open " << filename << " for writing." << std::endl;
+        return false;
+    }
+
+    file.precision(std::numeric_limits<float>::max_digits10);
+    file << "SPARSE 1\n";
+    file << sparse.getNbVoxels().x << " " << sparse.getNbVoxels().y << " " << sparse.getNbVoxels().z << "\n";
+    file << sparse.getMinCorner().x << " " << sparse.getMinCorner().y << " " << sparse.getMinCorner().z << "\n";
+    file << sparse.getVoxelSize() << "\n";
+    file << sparse.getNbBricks() << "\n";
+
+    std::vector<char> bytes;
+    for (std::size_t iB = 0 ; iB < sparse.getNbBricks() && file.good() ; ++iB) {
+        glm::uvec3 const& coords = sparse.brickCoords(iB);
+        const uint32_t words[3] = {coords.x, coords.y, coords.z};
+        toLittleEndian(words, 3, bytes);
+        file.write(bytes.data(), bytes.size());
+
+        toLittleEndian(sparse.brickWords(iB), SparseGrid::BRICK_WORDS, bytes);
+        file.write(bytes.data(), bytes.size());
+    }
+
+    if (!file.good()) {
+        std::cerr << "Error: couldn't write " << filename << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IO::writeAttributes(std::string const& filename,
+                         VoxelAttributes const& attributes,
+                         std::vector<Material> const& materials)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: couldn't open " << filename << " for writing." << std::endl;
+        return false;
+    }
+
+    std::vector<VoxelAttributes::Attribute> const& values = attributes.attributes();
+    glm::uvec3 const& nbVoxels = attributes.getNbVoxels();
+
+    file.precision(std::numeric_limits<float>::max_digits10);
+    file << "ATTRIBUTES 1\n";
+    file << nbVoxels.x << " " << nbVoxels.y << " " << nbVoxels.z << "\n";
+    file << values.size() << " " << materials.size() << "\n";
+    for (Material const& material : materials) {
+        file << (material.name.empty() ? "-" : material.name) << " "
+             << material.diffuse.r << " " << material.diffuse.g << " " << material.diffuse.b << "\n";
+    }
+
+    std::vector<uint32_t> words(4 * values.size());
+    for (std::size_t i = 0 ; i < values.size() ; ++i) {
+        std::memcpy(&words[4*i], &values[i].normal[0], 3 * sizeof(float));
+        words[4*i + 3] = (uint32_t)values[i].material;
+    }
+
+    std::vector<char> bytes;
+    toLittleEndian(words.data(), words.size(), bytes);
+    file.write(bytes.data(), bytes.size());
+
+    if (!file.good()) {
+        std::cerr << "Error: couldn't write " << filename << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IO::createVoxelsFile(std::string const& filename,
+                          glm::uvec3 const& nbVoxels,
+                          glm::vec3 const& minCorner,
+                          float voxelSize)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: couldn't open " << filename << " for writing." << std::endl;
+        return false;
+    }
+
+    writeHeader(file, nbVoxels, minCorner, voxelSize);
+
+    /* Writing the last byte is enough to have the (zero filled) grid */
+    const std::size_t nbWords = (std::size_t)nbVoxels.x * nbVoxels.y * (nbVoxels.z / 32);
+    if (nbWords > 0) {
+        file.seekp(4 * nbWords - 1, std::ios::cur);
+        file.put('\0');
+    }
+
+    if (!file.good()) {
+        std::cerr << "Error: couldn't write " << filename << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IO::writeVoxelsTile(std::string const& filename,
+                         glm::uvec3 const& nbVoxels,
+                         glm::uvec3 const& tileOrigin,
+                         glm::uvec3 const& tileSize,
+                         std::vector<uint32_t> const& tile)
+{
+    std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: couldn't open " << filename << " for writing." << std::endl;
+        return false;
+    }
+
+    /* The grid starts after the 4 header lines */
+    std::string line;
+    for (unsigned int i = 0 ; i < 4 ; ++i)
+        std::getline(file, line);
+    const std::streamoff gridStart = file.tellg();
+
+    /* Each row of the tile is contiguous in the file */
+    std::vector<char> bytes;
+    for (unsigned int iS = 0 ; iS < tileSize.z / 32 && file.good() ; ++iS) {
+        const std::size_t slab = tileOrigin.z / 32 + iS;
+        for (unsigned int iY = 0 ; iY < tileSize.y ; ++iY) {
+            const std::size_t word = (slab * nbVoxels.y + tileOrigin.y + iY) * nbVoxels.x + tileOrigin.x;
+            toLittleEndian(tile.data() + ((std::size_t)iS * tileSize.y + iY) * tileSize.x, tileSize.x, bytes);
+            file.seekp(gridStart + (std::streamoff)(4 * word));
+            file.write(bytes.data(), bytes.size());
+        }
+    }
+
+    if (!file.good()) {
+        std::cerr << "Error: couldn't write " << filename << "." << std::endl;
+        return false;
+    }
+    return true;
+}
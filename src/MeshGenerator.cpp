@@ -0,0 +1,135 @@
+#include "MeshGenerator.hpp"
+
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+
+/* Uniform in [0, 1), from the 24 high bits: unlike std::uniform_real_distribution, the same on every standard library */
+static float random01(std::mt19937& generator)
+{
+    return (generator() >> 8) * (1.f / 16777216.f);
+}
+
+/* Index of the vertex in the middle of the edge, pushed onto the unit sphere, created once per edge */
+static int midpoint(int a, int b, std::vector<glm::vec3>& vertices, std::unordered_map<uint64_t, int>& midpoints)
+{
+    const uint64_t key = ((uint64_t)std::min(a, b) << 32) | (uint32_t)std::max(a, b);
+    auto found = midpoints.find(key);
+    if (found != midpoints.end())
+        return found->second;
+
+    vertices.push_back(glm::normalize(vertices[a] + vertices[b]));
+    const int index = vertices.size() - 1;
+    midpoints[key] = index;
+    return index;
+}
+
+void MeshGenerator::sphere(unsigned int nbSubdivisions,
+                           std::vector<glm::vec3>& vertices,
+                           std::vector<glm::ivec3>& triangles)
+{
+    /* Icosahedron */
+    const float t = (1.f + std::sqrt(5.f)) / 2.f;
+    vertices = {{-1.f, t, 0.f}, {1.f, t, 0.f}, {-1.f, -t, 0.f}, {1.f, -t, 0.f},
+                {0.f, -1.f, t}, {0.f, 1.f, t}, {0.f, -1.f, -t}, {0.f, 1.f, -t},
+                {t, 0.f, -1.f}, {t, 0.f, 1.f}, {-t, 0.f, -1.f}, {-t, 0.f, 1.f}};
+    for (glm::vec3& vertex : vertices)
+        vertex = glm::normalize(vertex);
+    triangles = {{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+                 {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+                 {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+                 {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}};
+
+    /* Each triangle becomes 4, the edges shared by two triangles get a single midpoint */
+    std::unordered_map<uint64_t, int> midpoints;
+    for (unsigned int iS = 0 ; iS < nbSubdivisions ; ++iS) {
+        std::vector<glm::ivec3> subdivided;
+        subdivided.reserve(4 * triangles.size());
+        midpoints.clear();
+        midpoints.reserve(3 * triangles.size() / 2);
+        vertices.reserve(vertices.size() + 3 * triangles.size() / 2);
+        for (glm::ivec3 const& triangle : triangles) {
+            const int ab = midpoint(triangle.x, triangle.y, vertices, midpoints);
+            const int bc = midpoint(triangle.y, triangle.z, vertices, midpoints);
+            const int ca = midpoint(triangle.z, triangle.x, vertices, midpoints);
+            subdivided.push_back(glm::ivec3(triangle.x, ab, ca));
+            subdivided.push_back(glm::ivec3(triangle.y, bc, ab));
+            subdivided.push_back(glm::ivec3(triangle.z, ca, bc));
+            subdivided.push_back(glm::ivec3(ab, bc, ca));
+        }
+        triangles.swap(subdivided);
+    }
+}
+
+void MeshGenerator::triangleSoup(unsigned int nbTriangles, float maxEdge, uint32_t seed,
+                                 std::vector<glm::vec3>& vertices,
+                                 std::vector<glm::ivec3>& triangles)
+{
+    std::mt19937 generator(seed);
+    vertices.clear();
+    triangles.clear();
+    vertices.reserve(3 * nbTriangles);
+    triangles.reserve(nbTriangles);
+    for (unsigned int iT = 0 ; iT < nbTriangles ; ++iT) {
+        glm::vec3 origin;
+        for (int i = 0 ; i < 3 ; ++i)
+            origin[i] = (1.f - maxEdge) * random01(generator);
+
+        for (int iV = 0 ; iV < 3 ; ++iV) {
+            glm::vec3 vertex;
+            for (int i = 0 ; i < 3 ; ++i)
+                vertex[i] = origin[i] + maxEdge * random01(generator);
+            vertices.push_back(vertex);
+        }
+        triangles.push_back(glm::ivec3(3 * iT, 3 * iT + 1, 3 * iT + 2));
+    }
+}
+
+void MeshGenerator::thinPlates(unsigned int nbPlates, float thickness,
+                               std::vector<glm::vec3>& vertices,
+                               std::vector<glm::ivec3>& triangles)
+{
+    /* Box faces, counter-clockwise seen from outside. Corner i is at (i&1, (i>>1)&1, (i>>2)&1). */
+    static const int faces[12][3] = {{0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6},  //-Z, +Z
+                                     {0, 1, 4}, {1, 5, 4}, {2, 6, 3}, {3, 6, 7},  //-Y, +Y
+                                     {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}}; //-X, +X
+    vertices.clear();
+    triangles.clear();
+    for (unsigned int iP = 0 ; iP < nbPlates ; ++iP) {
+        const float bottom = (iP + 0.5f) / nbPlates - thickness / 2.f;
+        const int first = vertices.size();
+        for (int iC = 0 ; iC < 8 ; ++iC)
+            vertices.push_back(glm::vec3(iC & 1, (iC >> 1) & 1, bottom + ((iC >> 2) & 1) * thickness));
+        for (int iF = 0 ; iF < 12 ; ++iF)
+            triangles.push_back(glm::ivec3(first + faces[iF][0], first + faces[iF][1], first + faces[iF][2]));
+    }
+}
+
+bool MeshGenerator::generate(std::string const& description,
+                             std::vector<glm::vec3>& vertices,
+                             std::vector<glm::ivec3>& triangles)
+{
+    const std::size_t colon = description.find(':');
+    if (colon == std::string::npos)
+        return false;
+
+    std::stringstream ss(description.substr(colon + 1));
+    unsigned int parameter = 0;
+    if (!(ss >> parameter) || !ss.eof())
+        return false;
+
+    const std::string name = description.substr(0, colon);
+    if (name == "sphere" && parameter <= 10)
+        sphere(parameter, vertices, triangles);
+    else if (name == "soup" && parameter > 0)
+        triangleSoup(parameter, 0.02f, 1u, vertices, triangles);
+    else if (name == "plates" && parameter > 0)
+        thinPlates(parameter, 0.25f / 1024.f, vertices, triangles); //a quarter of a voxel at 1024
+    else
+        return false;
+    return true;
+}
@@ -1,6 +1,9 @@
 #include "MeshRenderable.hpp"
 
 
+#include <algorithm>
+#include <numeric>
+
 #include "GLHelper.hpp"
 #include "IO.hpp"
 
@@ -9,11 +12,42 @@ MeshRenderable::MeshRenderable(std::string const& filename):
             _verticesNormalsBufferId(-1),
             _indicesBufferId(-1),
             _vaoId(-1),
+            _sorted(false),
+            _maxExtents{0.f, 0.f, 0.f},
+            _sortedIndicesBufferId(-1),
+            _sortedVaoId(-1),
             _modelMatrix(glm::mat4(1.f))
 {
     /* File loading */
     IO::readObj(filename, _vertices, _normals, _indices);
 
+    createBuffers();
+}
+
+MeshRenderable::MeshRenderable(std::vector<glm::vec3> const& vertices,
+                               std::vector<glm::vec3> const& normals,
+                               std::vector<glm::ivec3> const& indices):
+            _vertices(vertices),
+            _normals(normals),
+            _indices(indices),
+            _verticesNormalsBufferId(-1),
+            _indicesBufferId(-1),
+            _vaoId(-1),
+            _sorted(false),
+            _maxExtents{0.f, 0.f, 0.f},
+            _sortedIndicesBufferId(-1),
+            _sortedVaoId(-1),
+            _modelMatrix(glm::mat4(1.f))
+{
+    createBuffers();
+}
+
+void MeshRenderable::createBuffers()
+{
+    /* The normals are optional in .OBJ files */
+    if (_normals.size() != _vertices.size())
+        _normals.resize(_vertices.size(), glm::vec3(0.f));
+
     std::vector<glm::vec3> verticesNormals(2*_vertices.size());
     for (std::size_t i = 0 ; i < _vertices.size() ; ++i) {
         verticesNormals[2*i+0] = _vertices[i];
@@ -29,26 +63,64 @@ MeshRenderable::MeshRenderable(std::string const& filename):
     GLCHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indicesBufferId));
     GLCHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indices.size()*sizeof(glm::ivec3), _indices.data(), GL_STATIC_DRAW));
 
-    /*  VAO creation and binding */
-    {
-        const GLint vertALoc = 0;
-        const GLint normalALoc = 1;
+    createVAO(_vaoId, _indicesBufferId);
+}
 
-        GLCHECK(glGenVertexArrays(1, &_vaoId));
-        GLCHECK(glBindVertexArray(_vaoId));
+void MeshRenderable::createVAO(GLuint& vaoId, GLuint indicesBufferId)
+{
+    const GLint vertALoc = 0;
+    const GLint normalALoc = 1;
 
-        GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, _verticesNormalsBufferId));
+    GLCHECK(glGenVertexArrays(1, &vaoId));
+    GLCHECK(glBindVertexArray(vaoId));
 
-        GLCHECK(glEnableVertexAttribArray(vertALoc));
-        GLCHECK(glVertexAttribPointer(vertALoc, 3, GL_FLOAT, GL_FALSE, 2*sizeof(glm::vec3), (void*)0));
+    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, _verticesNormalsBufferId));
+
+    GLCHECK(glEnableVertexAttribArray(vertALoc));
+    GLCHECK(glVertexAttribPointer(vertALoc, 3, GL_FLOAT, GL_FALSE, 2*sizeof(glm::vec3), (void*)0));
 
-        GLCHECK(glEnableVertexAttribArray(normalALoc));
-        GLCHECK(glVertexAttribPointer(normalALoc, 3, GL_FLOAT, GL_FALSE, 2*sizeof(glm::vec3), (void*)sizeof(glm::vec3)));
+    GLCHECK(glEnableVertexAttribArray(normalALoc));
+    GLCHECK(glVertexAttribPointer(normalALoc, 3, GL_FLOAT, GL_FALSE, 2*sizeof(glm::vec3), (void*)sizeof(glm::vec3)));
 
-        GLCHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indicesBufferId));
+    GLCHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesBufferId));
 
-        GLCHECK(glBindVertexArray(0));
+    GLCHECK(glBindVertexArray(0));
+}
+
+void MeshRenderable::sortTriangles()
+{
+    if (_sorted)
+        return;
+
+    std::vector<glm::ivec3> sortedIndices;
+    sortedIndices.reserve(3 * _indices.size());
+    for (unsigned int axis = 0 ; axis < 3 ; ++axis) {
+        std::vector<float> minCoords(_indices.size()), maxCoords(_indices.size());
+        for (std::size_t i = 0 ; i < _indices.size() ; ++i) {
+            const glm::ivec3& t = _indices[i];
+            minCoords[i] = std::min(_vertices[t.x][axis], std::min(_vertices[t.y][axis], _vertices[t.z][axis]));
+            maxCoords[i] = std::max(_vertices[t.x][axis], std::max(_vertices[t.y][axis], _vertices[t.z][axis]));
+        }
+
+        std::vector<std::size_t> order(_indices.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return minCoords[a] < minCoords[b]; });
+
+        _sortedMinCoords[axis].resize(order.size());
+        _maxExtents[axis] = 0.f;
+        for (std::size_t i = 0 ; i < order.size() ; ++i) {
+            sortedIndices.push_back(_indices[order[i]]);
+            _sortedMinCoords[axis][i] = minCoords[order[i]];
+            _maxExtents[axis] = std::max(_maxExtents[axis], maxCoords[order[i]] - minCoords[order[i]]);
+        }
     }
+
+    GLCHECK(glGenBuffers(1, &_sortedIndicesBufferId));
+    GLCHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sortedIndicesBufferId));
+    GLCHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sortedIndices.size()*sizeof(glm::ivec3), sortedIndices.data(), GL_STATIC_DRAW));
+    createVAO(_sortedVaoId, _sortedIndicesBufferId);
+
+    _sorted = true;
 }
 
 MeshRenderable::~MeshRenderable()
@@ -62,6 +134,12 @@ MeshRenderable::~MeshRenderable()
     if (_indicesBufferId != (GLuint)(-1)) {
         GLCHECK(glDeleteBuffers(1, &_indicesBufferId));
     }
+    if (_sortedVaoId != (GLuint)(-1)) {
+        GLCHECK(glDeleteVertexArrays(1, &_sortedVaoId));
+    }
+    if (_sortedIndicesBufferId != (GLuint)(-1)) {
+        GLCHECK(glDeleteBuffers(1, &_sortedIndicesBufferId));
+    }
 }
 
 std::vector<glm::vec3> const& MeshRenderable::vertices() const
@@ -96,3 +174,44 @@ void MeshRenderable::draw(ShaderProgram& shader) const
     GLCHECK(glDrawElements(GL_TRIANGLES, 3*_indices.size(), GL_UNSIGNED_INT, (void*)0));
     GLCHECK(glBindVertexArray(0));
 }
+
+void MeshRenderable::drawInstanced(ShaderProgram& shader, unsigned int nbInstances) const
+{
+    if (!shader.isValid() || nbInstances == 0)
+        return;
+
+    GLuint modelMatrixULoc = shader.getUniformLocation("modelMatrix");
+    if(modelMatrixULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniformMatrix4fv(modelMatrixULoc, 1, GL_FALSE, glm::value_ptr(_modelMatrix)));
+    }
+
+    GLCHECK(glBindVertexArray(_vaoId));
+    GLCHECK(glDrawElementsInstanced(GL_TRIANGLES, 3*_indices.size(), GL_UNSIGNED_INT, (void*)0, nbInstances));
+    GLCHECK(glBindVertexArray(0));
+}
+
+void MeshRenderable::drawRange(ShaderProgram& shader, unsigned int axis, float minCoord, float maxCoord) const
+{
+    if (!_sorted || axis > 2) {
+        draw(shader);
+        return;
+    }
+    if (!shader.isValid())
+        return;
+
+    std::vector<float> const& minCoords = _sortedMinCoords[axis];
+    const std::size_t first = std::lower_bound(minCoords.begin(), minCoords.end(), minCoord - _maxExtents[axis]) - minCoords.begin();
+    const std::size_t last = std::upper_bound(minCoords.begin(), minCoords.end(), maxCoord) - minCoords.begin();
+    if (first >= last)
+        return;
+
+    GLuint modelMatrixULoc = shader.getUniformLocation("modelMatrix");
+    if(modelMatrixULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniformMatrix4fv(modelMatrixULoc, 1, GL_FALSE, glm::value_ptr(_modelMatrix)));
+    }
+
+    const std::size_t offset = axis * _indices.size() + first;
+    GLCHECK(glBindVertexArray(_sortedVaoId));
+    GLCHECK(glDrawElements(GL_TRIANGLES, 3*(last - first), GL_UNSIGNED_INT, (void*)(offset * sizeof(glm::ivec3))));
+    GLCHECK(glBindVertexArray(0));
+}
@@ -30,6 +30,8 @@ Scene::Scene(unsigned int screenWidth, unsigned int screenHeight,
         std::cerr << "Error: unable to load voxels shader." << std::endl;
     }
 
+    /* The grid is only displayed: it doesn't need to come back to the CPU */
+    _voxelizer.setOutput(Voxelizer::Output::Texture);
     recompute();
 }
 
@@ -48,6 +50,12 @@ void Scene::recompute()
 
     std::cout << "\nGrid size: " << _voxelizer.getNbVoxels().x << "x" << _voxelizer.getNbVoxels().y << "x" << _voxelizer.getNbVoxels().z;
     std::cout << " computed in " << clock.getElapsedTime().asSeconds() << " s\n";
+
+    /* The call itself mostly waits, the GPU passes tell where the time goes */
+    Voxelizer::Stats const& stats = _voxelizer.lastStats();
+    std::cout << "GPU passes (ms): projections " << stats.xProjection << " / " << stats.yProjection << " / " << stats.zProjection
+              << ", image " << stats.imageDraw << ", compile " << stats.compile << ", readback " << stats.readback
+              << ", pyramid " << stats.pyramid << "\n";
     clock.restart();
 
     _voxelsRenderer.reset(new VoxelsRenderable(_voxelizer));
@@ -33,10 +33,12 @@ static GLuint compileShader(std::string const& shaderText, GLuint type)
     std::string shaderType;
     if (type == GL_VERTEX_SHADER)
         shaderType = "vertex";
+    else if (type == GL_GEOMETRY_SHADER)
+        shaderType = "geometry";
     else if (type == GL_FRAGMENT_SHADER)
         shaderType = "fragment";
     else {
-        std::cerr << "Error: only vertex and fragment shader are supported." << std::endl;
+        std::cerr << "Error: only vertex, geometry and fragment shader are supported." << std::endl;
         return 0;
     }
 
@@ -84,7 +86,8 @@ ShaderProgram::ShaderProgram():
 
 ShaderProgram::~ShaderProgram()
 {
-    if (glIsProgram(_programId) == GL_TRUE) {
+    /* A never loaded shader may live without any OpenGL context */
+    if (_programId != 0 && glIsProgram(_programId) == GL_TRUE) {
         GLCHECK(glDeleteProgram(_programId));
     }
 }
@@ -96,19 +99,54 @@ bool ShaderProgram::loadFromFile(std::string const& vertexFilename, std::string
     return loadFromString(vertexShader, fragmentShader);
 }
 
+bool ShaderProgram::loadFromFile(std::string const& vertexFilename, std::string const& geometryFilename, std::string const& fragmentFilename)
+{
+    std::string vertexShader = loadFile(vertexFilename);
+    std::string geometryShader = loadFile(geometryFilename);
+    std::string fragmentShader = fragmentFilename.empty() ? std::string() : loadFile(fragmentFilename);
+    if (geometryShader.empty()) {
+        std::cerr << "Couldn't load new shader program: empty geometry shader. Shader program unchanged." << std::endl;
+        return false;
+    }
+    return loadFromString(vertexShader, geometryShader, fragmentShader);
+}
+
 bool ShaderProgram::loadFromString(std::string const& vertexShader, std::string const& fragmentShader)
 {
-    GLuint vertexShaderId = compileShader(vertexShader, GL_VERTEX_SHADER);
-    GLuint fragmentShaderId = compileShader(fragmentShader, GL_FRAGMENT_SHADER);
+    return loadFromString(vertexShader, std::string(), fragmentShader);
+}
+
+bool ShaderProgram::loadFromString(std::string const& vertexShader, std::string const& geometryShader, std::string const& fragmentShader)
+{
+    std::vector<GLuint> shaderIds;
+    shaderIds.push_back(compileShader(vertexShader, GL_VERTEX_SHADER));
+    if (!geometryShader.empty())
+        shaderIds.push_back(compileShader(geometryShader, GL_GEOMETRY_SHADER));
+    /* Transform feedback may be used alone, with the rasterization disabled */
+    if (!fragmentShader.empty() || _feedbackVaryings.empty())
+        shaderIds.push_back(compileShader(fragmentShader, GL_FRAGMENT_SHADER));
+
+    std::string description = "vertex shader [" + vertexShader + "]";
+    if (!geometryShader.empty())
+        description += ", geometry shader [" + geometryShader + "]";
+    description += " and fragment shader [" + fragmentShader + "]";
+
+    return linkProgram(shaderIds, description);
+}
+
+bool ShaderProgram::linkProgram(std::vector<GLuint> const& shaderIds, std::string const& description)
+{
+    bool compiled = true;
+    for (GLuint shaderId : shaderIds)
+        compiled = compiled && (shaderId != 0);
 
-    if (vertexShaderId == 0 || fragmentShaderId == 0) {
+    if (!compiled) {
         std::cerr << "Couldn't load new shader program. Shader program unchanged." << std::endl;
 
-        if (vertexShaderId == 0) {
-            GLCHECK(glDeleteShader(vertexShaderId));
-        }
-        if (fragmentShaderId == 0) {
-            GLCHECK(glDeleteShader(fragmentShaderId));
+        for (GLuint shaderId : shaderIds) {
+            if (shaderId != 0) {
+                GLCHECK(glDeleteShader(shaderId));
+            }
         }
         return false;
     }
@@ -119,19 +157,33 @@ bool ShaderProgram::loadFromString(std::string const& vertexShader, std::string
     GLCHECK(_programId = glCreateProgram());
     if (_programId == 0) {
         std::cerr << "Couldn't create new shader program. Shader program unchanged." << std::endl;
+        for (GLuint shaderId : shaderIds) {
+            GLCHECK(glDeleteShader(shaderId));
+        }
         _programId = previousProgramId;
         return false;
     }
 
-    GLCHECK(glAttachShader(_programId, vertexShaderId));
-    GLCHECK(glAttachShader(_programId, fragmentShaderId));
+    for (GLuint shaderId : shaderIds) {
+        GLCHECK(glAttachShader(_programId, shaderId));
+    }
+    if (!_feedbackVaryings.empty()) {
+        std::vector<GLchar const*> varyings;
+        for (std::string const& varying : _feedbackVaryings)
+            varyings.push_back(varying.c_str());
+        GLCHECK(glTransformFeedbackVaryings(_programId, varyings.size(), varyings.data(), GL_INTERLEAVED_ATTRIBS));
+    }
     GLCHECK(glLinkProgram(_programId));
 
      GLint linkStatus;
      GLCHECK(glGetProgramiv(_programId, GL_LINK_STATUS, &linkStatus));
      if (linkStatus == GL_FALSE) {
-        std::cerr << "Couldn't link shader program made of vertex shader [" << vertexShader << "] and fragment shader [" << fragmentShader << "].";
+        std::cerr << "Couldn't link shader program made of " << description << ".";
         std::cerr << " Shader program unchanged." << std::endl;
+        GLCHECK(glDeleteProgram(_programId));
+        for (GLuint shaderId : shaderIds) {
+            GLCHECK(glDeleteShader(shaderId));
+        }
         _programId = previousProgramId;
         return false;
      }
@@ -141,8 +193,9 @@ bool ShaderProgram::loadFromString(std::string const& vertexShader, std::string
         GLCHECK(glDeleteProgram(previousProgramId));
     }
 
-    GLCHECK(glDeleteShader(vertexShaderId));
-    GLCHECK(glDeleteShader(fragmentShaderId));
+    for (GLuint shaderId : shaderIds) {
+        GLCHECK(glDeleteShader(shaderId));
+    }
 
     queryActiveAttributesLocation();
     queryActiveUniformsLocation();
@@ -151,6 +204,11 @@ bool ShaderProgram::loadFromString(std::string const& vertexShader, std::string
     return true;
 }
 
+void ShaderProgram::setTransformFeedbackVaryings(std::vector<std::string> const& varyings)
+{
+    _feedbackVaryings = varyings;
+}
+
 void ShaderProgram::bind(ShaderProgram& program)
 {
     GLCHECK(glUseProgram(program._programId));
@@ -0,0 +1,116 @@
+#include "SparseGrid.hpp"
+
+
+#include <algorithm>
+
+
+SparseGrid::SparseGrid():
+            _nbVoxels(0u, 0u, 0u),
+            _nbBricks(0u, 0u, 0u),
+            _minCorner(0.f, 0.f, 0.f),
+            _voxelSize(0.f)
+{
+}
+
+void SparseGrid::reset(glm::uvec3 const& nbVoxels, glm::vec3 const& minCorner, float voxelSize)
+{
+    _nbVoxels = nbVoxels;
+    _nbBricks = nbVoxels / BRICK_SIZE;
+    _minCorner = minCorner;
+    _voxelSize = voxelSize;
+
+    _table.assign((std::size_t)_nbBricks.x * _nbBricks.y * _nbBricks.z, 0u);
+    _brickCoords.clear();
+    _words.clear();
+}
+
+std::size_t SparseGrid::tableIndex(glm::uvec3 const& brick) const
+{
+    return ((std::size_t)brick.z * _nbBricks.y + brick.y) * _nbBricks.x + brick.x;
+}
+
+uint32_t* SparseGrid::addBrick(glm::uvec3 const& brick)
+{
+    uint32_t& index = _table[tableIndex(brick)];
+    if (index == 0) {
+        _brickCoords.push_back(brick);
+        _words.resize(_words.size() + BRICK_WORDS, 0u);
+        index = _brickCoords.size();
+    }
+    return _words.data() + (std::size_t)(index - 1) * BRICK_WORDS;
+}
+
+uint32_t const* SparseGrid::brick(glm::uvec3 const& brick) const
+{
+    if (glm::any(glm::greaterThanEqual(brick, _nbBricks)))
+        return nullptr;
+
+    const uint32_t index = _table[tableIndex(brick)];
+    return (index == 0) ? nullptr : _words.data() + (std::size_t)(index - 1) * BRICK_WORDS;
+}
+
+bool SparseGrid::voxel(unsigned int iX, unsigned int iY, unsigned int iZ) const
+{
+    uint32_t const* words = brick(glm::uvec3(iX, iY, iZ) / BRICK_SIZE);
+    if (words == nullptr)
+        return false;
+
+    const uint32_t word = words[(iY % BRICK_SIZE) * BRICK_SIZE + iX % BRICK_SIZE];
+    return (word >> (iZ % BRICK_SIZE)) & 1u;
+}
+
+std::size_t SparseGrid::getNbBricks() const
+{
+    return _brickCoords.size();
+}
+
+glm::uvec3 const& SparseGrid::brickCoords(std::size_t iBrick) const
+{
+    return _brickCoords[iBrick];
+}
+
+uint32_t const* SparseGrid::brickWords(std::size_t iBrick) const
+{
+    return _words.data() + iBrick * BRICK_WORDS;
+}
+
+std::vector<uint32_t> SparseGrid::toGrid() const
+{
+    std::vector<uint32_t> grid((std::size_t)_nbVoxels.x * _nbVoxels.y * _nbVoxels.z / 32, 0u);
+
+    /* Rows of 32 words */
+    for (std::size_t iB = 0 ; iB < _brickCoords.size() ; ++iB) {
+        const glm::uvec3 origin = BRICK_SIZE * _brickCoords[iB];
+        for (unsigned int iY = 0 ; iY < BRICK_SIZE ; ++iY) {
+            uint32_t const* from = brickWords(iB) + iY * BRICK_SIZE;
+            const std::size_t to = ((std::size_t)(origin.z / 32) * _nbVoxels.y + origin.y + iY) * _nbVoxels.x + origin.x;
+            std::copy(from, from + BRICK_SIZE, grid.begin() + to);
+        }
+    }
+    return grid;
+}
+
+std::size_t SparseGrid::getMemorySize() const
+{
+    return _table.size() * sizeof(uint32_t) + _brickCoords.size() * sizeof(glm::uvec3) + _words.size() * sizeof(uint32_t);
+}
+
+glm::uvec3 const& SparseGrid::getNbVoxels() const
+{
+    return _nbVoxels;
+}
+
+glm::uvec3 const& SparseGrid::getBrickDimensions() const
+{
+    return _nbBricks;
+}
+
+glm::vec3 const& SparseGrid::getMinCorner() const
+{
+    return _minCorner;
+}
+
+float SparseGrid::getVoxelSize() const
+{
+    return _voxelSize;
+}
@@ -0,0 +1,111 @@
+#include "ToolHelpers.hpp"
+
+
+#include <bitset>
+#include <iostream>
+#include <sstream>
+
+#include "IO.hpp"
+#include "MeshGenerator.hpp"
+
+
+bool ToolHelpers::parseBackend(std::string const& name, Voxelizer::Backend& backend)
+{
+    if (name == "gpu")
+        backend = Voxelizer::Backend::GPU;
+    else if (name == "cpu")
+        backend = Voxelizer::Backend::CPU;
+    else
+        return false;
+    return true;
+}
+
+bool ToolHelpers::parseGPUMethod(std::string const& name, Voxelizer::GPUMethod& method)
+{
+    if (name == "auto")
+        method = Voxelizer::GPUMethod::Auto;
+    else if (name == "projections")
+        method = Voxelizer::GPUMethod::Projections;
+    else if (name == "layered")
+        method = Voxelizer::GPUMethod::LayeredProjections;
+    else if (name == "image")
+        method = Voxelizer::GPUMethod::ImageAtomics;
+    else if (name == "dominant")
+        method = Voxelizer::GPUMethod::DominantAxis;
+    else
+        return false;
+    return true;
+}
+
+std::string ToolHelpers::gpuMethodName(Voxelizer::GPUMethod method)
+{
+    switch (method) {
+        case Voxelizer::GPUMethod::Projections:
+            return "projections";
+        case Voxelizer::GPUMethod::LayeredProjections:
+            return "layered";
+        case Voxelizer::GPUMethod::ImageAtomics:
+            return "image";
+        case Voxelizer::GPUMethod::DominantAxis:
+            return "dominant";
+        default:
+            return "auto";
+    }
+}
+
+bool ToolHelpers::parseMode(std::string const& name, Voxelizer::Mode& mode)
+{
+    if (name == "surface")
+        mode = Voxelizer::Mode::Surface;
+    else if (name == "conservative6")
+        mode = Voxelizer::Mode::Conservative6;
+    else if (name == "conservative26")
+        mode = Voxelizer::Mode::Conservative26;
+    else if (name == "solid")
+        mode = Voxelizer::Mode::Solid;
+    else
+        return false;
+    return true;
+}
+
+bool ToolHelpers::parseResolutions(std::string const& list, std::vector<unsigned int>& resolutions)
+{
+    std::stringstream ss(list);
+    std::string item;
+    bool empty = true;
+    while (std::getline(ss, item, ',')) {
+        std::stringstream itemStream(item);
+        int resolution = 0;
+        if (!(itemStream >> resolution) || resolution < 1 || !itemStream.eof())
+            return false;
+        resolutions.push_back(resolution);
+        empty = false;
+    }
+    return !empty;
+}
+
+std::size_t ToolHelpers::countVoxels(uint32_t const* words, std::size_t nbWords)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0 ; i < nbWords ; ++i)
+        count += std::bitset<32>(words[i]).count();
+    return count;
+}
+
+std::size_t ToolHelpers::countVoxels(std::vector<uint32_t> const& grid)
+{
+    return countVoxels(grid.data(), grid.size());
+}
+
+bool ToolHelpers::loadMesh(std::string const& name,
+                           std::vector<glm::vec3>& vertices,
+                           std::vector<glm::vec3>& normals,
+                           std::vector<glm::ivec3>& triangles)
+{
+    normals.clear();
+    if (MeshGenerator::generate(name, vertices, triangles) || IO::readObj(name, vertices, normals, triangles))
+        return true;
+
+    std::cerr << "Error: \"" << name << "\" is neither a mesh file nor a generated mesh." << std::endl;
+    return false;
+}
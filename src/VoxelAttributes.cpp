@@ -0,0 +1,157 @@
+#include "VoxelAttributes.hpp"
+
+
+#include <bitset>
+#include <cmath>
+#include <algorithm>
+
+#include "CPUVoxelization.hpp"
+
+
+static const std::size_t WORDS_PER_BLOCK = 8;
+
+const std::size_t VoxelAttributes::npos = (std::size_t)(-1);
+
+
+static inline unsigned int popcount(uint32_t v)
+{
+    return std::bitset<32>(v).count();
+}
+
+/* Range of the voxels [i,i+1] overlapping [minCoord,maxCoord], clamped to [0,n-1].
+ * @return false if empty */
+static bool voxelRange(float minCoord, float maxCoord, unsigned int n, unsigned int& first, unsigned int& last)
+{
+    const float lowest = std::max(0.f, std::ceil(minCoord) - 1.f);
+    const float highest = std::min((float)n - 1.f, std::floor(maxCoord));
+    if (lowest > highest)
+        return false;
+
+    first = (unsigned int)lowest;
+    last = (unsigned int)highest;
+    return true;
+}
+
+VoxelAttributes::VoxelAttributes():
+            _nbVoxels(0u, 0u, 0u),
+            _grid(nullptr)
+{
+}
+
+void VoxelAttributes::compute(std::vector<uint32_t> const& grid,
+                              glm::uvec3 const& nbVoxels,
+                              glm::vec3 const& minCorner,
+                              float voxelSize,
+                              std::vector<glm::vec3> const& vertices,
+                              std::vector<glm::ivec3> const& triangles,
+                              std::vector<int> const& triangleMaterials)
+{
+    _nbVoxels = nbVoxels;
+    _grid = &grid;
+
+    /* Rank index */
+    _blockRanks.assign((grid.size() + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK, 0u);
+    uint64_t nbSet = 0;
+    for (std::size_t i = 0 ; i < grid.size() ; ++i) {
+        if (i % WORDS_PER_BLOCK == 0)
+            _blockRanks[i / WORDS_PER_BLOCK] = nbSet;
+        nbSet += popcount(grid[i]);
+    }
+
+    const Attribute none = {glm::vec3(0.f), -1};
+    _attributes.assign(nbSet, none);
+    std::vector<float> materialAreas(nbSet, 0.f);
+
+    /* Each triangle adds its normal to the set voxels it overlaps */
+    const CPUVoxelization::ColumnKernel kernel = CPUVoxelization::columnKernel(CPUVoxelization::ISA::Auto);
+    for (std::size_t iT = 0 ; iT < triangles.size() ; ++iT) {
+        glm::ivec3 const& t = triangles[iT];
+        const glm::vec3 areaNormal = 0.5f * glm::cross(vertices[t.y] - vertices[t.x], vertices[t.z] - vertices[t.x]);
+        const float area = glm::length(areaNormal);
+        const int material = (iT < triangleMaterials.size()) ? triangleMaterials[iT] : -1;
+
+        const CPUVoxelization::TriangleBoxTest test((vertices[t.x] - minCorner) / voxelSize,
+                                                    (vertices[t.y] - minCorner) / voxelSize,
+                                                    (vertices[t.z] - minCorner) / voxelSize);
+        unsigned int firstX, lastX, firstY, lastY, firstZ, lastZ;
+        if (!voxelRange(test.minCoords.x, test.maxCoords.x, nbVoxels.x, firstX, lastX) ||
+            !voxelRange(test.minCoords.y, test.maxCoords.y, nbVoxels.y, firstY, lastY) ||
+            !voxelRange(test.minCoords.z, test.maxCoords.z, nbVoxels.z, firstZ, lastZ))
+            continue;
+
+        for (unsigned int iS = firstZ / 32 ; iS <= lastZ / 32 ; ++iS) {
+            const unsigned int slabFirstZ = std::max(firstZ, 32 * iS);
+            const unsigned int slabLastZ = std::min(lastZ, 32 * iS + 31);
+            for (unsigned int iY = firstY ; iY <= lastY ; ++iY) {
+                for (unsigned int iX = firstX ; iX <= lastX ; ++iX) {
+                    const std::size_t word = wordIndex(iX, iY, 32 * iS);
+                    uint32_t overlapped = grid[word] & kernel(test, iX, iY, slabFirstZ, slabLastZ);
+                    if (!overlapped)
+                        continue;
+
+                    const std::size_t rank = wordRank(word);
+                    for (unsigned int bit = 0 ; bit < 32 ; ++bit) {
+                        if (!(overlapped & (1u << bit)))
+                            continue;
+
+                        const std::size_t i = rank + popcount(grid[word] & ((1u << bit) - 1u));
+                        _attributes[i].normal += areaNormal;
+                        if (material >= 0 && area > materialAreas[i]) {
+                            materialAreas[i] = area;
+                            _attributes[i].material = material;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (Attribute& attribute : _attributes) {
+        const float length = glm::length(attribute.normal);
+        if (length > 0.f)
+            attribute.normal /= length;
+    }
+}
+
+std::size_t VoxelAttributes::wordIndex(unsigned int iX, unsigned int iY, unsigned int iZ) const
+{
+    return ((std::size_t)(iZ / 32) * _nbVoxels.y + iY) * _nbVoxels.x + iX;
+}
+
+std::size_t VoxelAttributes::wordRank(std::size_t word) const
+{
+    std::size_t rank = _blockRanks[word / WORDS_PER_BLOCK];
+    for (std::size_t i = word - word % WORDS_PER_BLOCK ; i < word ; ++i)
+        rank += popcount((*_grid)[i]);
+    return rank;
+}
+
+std::size_t VoxelAttributes::rank(unsigned int iX, unsigned int iY, unsigned int iZ) const
+{
+    if (iX >= _nbVoxels.x || iY >= _nbVoxels.y || iZ >= _nbVoxels.z)
+        return npos;
+
+    const std::size_t word = wordIndex(iX, iY, iZ);
+    const uint32_t bit = 1u << (iZ % 32);
+    const uint32_t bits = (*_grid)[word];
+    if (!(bits & bit))
+        return npos;
+
+    return wordRank(word) + popcount(bits & (bit - 1u));
+}
+
+VoxelAttributes::Attribute const* VoxelAttributes::at(unsigned int iX, unsigned int iY, unsigned int iZ) const
+{
+    const std::size_t i = rank(iX, iY, iZ);
+    return (i == npos) ? nullptr : &_attributes[i];
+}
+
+std::vector<VoxelAttributes::Attribute> const& VoxelAttributes::attributes() const
+{
+    return _attributes;
+}
+
+glm::uvec3 const& VoxelAttributes::getNbVoxels() const
+{
+    return _nbVoxels;
+}
@@ -5,14 +5,18 @@
 #include <fstream>
 #include <sstream>
 #include <limits>
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <dlfcn.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/component_wise.hpp>
 #include <GL/glew.h>
 #include <SFML/OpenGL.hpp>
-#include <SFML/Graphics/Image.hpp>
 
 #include "ShaderProgram.hpp"
+#include "CPUVoxelization.hpp"
 #include "GLHelper.hpp"
 #include "glm.hpp"
 
@@ -30,11 +34,50 @@ static unsigned int makeMultipleOf32(unsigned int n)
     return n;
 }
 
-static void allocate3DTexture(GLuint& id, unsigned int width, unsigned int height, unsigned int depth)
+/* The current EGL or GLX context, looked up at runtime so that neither library has to be linked. nullptr if unknown. */
+static void* currentContext()
 {
+    typedef void* (*GetCurrentContext)();
+    static const GetCurrentContext eglGetCurrent = reinterpret_cast<GetCurrentContext>(dlsym(RTLD_DEFAULT, "eglGetCurrentContext"));
+    static const GetCurrentContext glXGetCurrent = reinterpret_cast<GetCurrentContext>(dlsym(RTLD_DEFAULT, "glXGetCurrentContext"));
+    void* context = eglGetCurrent ? eglGetCurrent() : nullptr;
+    if (!context && glXGetCurrent)
+        context = glXGetCurrent();
+    return context;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point const& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Idle textures kept in the pool, the least recently used ones are deleted first */
+static const std::size_t MAX_IDLE_TEXTURES = 6;
+
+/* Size of the image holding the grids of one instanced draw (see recomputeTransformed) */
+static const std::size_t MAX_INSTANCED_BYTES = 16 << 20;
+
+/* Slabs a layered draw can reach, bounded by the geometry shader's output (MAX_SLABS in layeredSlice.geom) */
+static const unsigned int MAX_LAYERED_SLABS = 64;
+
+/* Integer formats of the slabs, by number of 32 bits channels */
+static GLenum slabFormat(unsigned int nbChannels)
+{
+    return (nbChannels == 4) ? GL_RGBA32UI : ((nbChannels == 2) ? GL_RG32UI : GL_R32UI);
+}
+
+static GLenum pixelFormat(unsigned int nbChannels)
+{
+    return (nbChannels == 4) ? GL_RGBA_INTEGER : ((nbChannels == 2) ? GL_RG_INTEGER : GL_RED_INTEGER);
+}
+
+static void allocate3DTexture(GLuint& id, GLenum internalFormat, unsigned int width, unsigned int height, unsigned int depth)
+{
+    const unsigned int nbChannels = (internalFormat == GL_RGBA32UI) ? 4 : ((internalFormat == GL_RG32UI) ? 2 : 1);
     GLCHECK(glGenTextures(1, &id));
     GLCHECK(glBindTexture(GL_TEXTURE_3D, id));
-    GLCHECK(glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8UI, width, height, depth, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT_8_8_8_8, 0));
+    GLCHECK(glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, width, height, depth, 0,
+                         pixelFormat(nbChannels), GL_UNSIGNED_INT, 0));
 
     GLCHECK(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
     GLCHECK(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
@@ -43,244 +86,2159 @@ static void allocate3DTexture(GLuint& id, unsigned int width, unsigned int heigh
     GLCHECK(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 }
 
-Voxelizer::Voxelizer():
+/* Greedy merge of the selected (non-zero) blocks of 32 voxels into disjoint boxes, in Z, Y, X order:
+ * each box grows along X, then Y, then Z, as long as all its blocks are selected. The blocks are unselected on the way. */
+static void mergeBlocks(std::vector<uint32_t>& blocks, glm::uvec3 const& nbBlocks, std::vector<Voxelizer::Box>& boxes)
+{
+    auto blockIndex = [&](unsigned int iX, unsigned int iY, unsigned int iZ) {
+        return ((std::size_t)iZ * nbBlocks.y + iY) * nbBlocks.x + iX;
+    };
+    for (unsigned int iZ = 0 ; iZ < nbBlocks.z ; ++iZ) {
+        for (unsigned int iY = 0 ; iY < nbBlocks.y ; ++iY) {
+            for (unsigned int iX = 0 ; iX < nbBlocks.x ; ++iX) {
+                if (!blocks[blockIndex(iX, iY, iZ)])
+                    continue;
+
+                glm::uvec3 last(iX, iY, iZ);
+                while (last.x + 1 < nbBlocks.x && blocks[blockIndex(last.x + 1, iY, iZ)])
+                    ++last.x;
+                for (bool full = true ; full && last.y + 1 < nbBlocks.y ; ) {
+                    for (unsigned int x = iX ; x <= last.x && full ; ++x)
+                        full = blocks[blockIndex(x, last.y + 1, iZ)];
+                    last.y += full ? 1 : 0;
+                }
+                for (bool full = true ; full && last.z + 1 < nbBlocks.z ; ) {
+                    for (unsigned int y = iY ; y <= last.y && full ; ++y) {
+                        for (unsigned int x = iX ; x <= last.x && full ; ++x)
+                            full = blocks[blockIndex(x, y, last.z + 1)];
+                    }
+                    last.z += full ? 1 : 0;
+                }
+
+                for (unsigned int z = iZ ; z <= last.z ; ++z) {
+                    for (unsigned int y = iY ; y <= last.y ; ++y) {
+                        for (unsigned int x = iX ; x <= last.x ; ++x)
+                            blocks[blockIndex(x, y, z)] = 0u;
+                    }
+                }
+                const glm::uvec3 origin(iX, iY, iZ);
+                boxes.push_back({32u * origin, 32u * (last - origin + 1u)});
+            }
+        }
+    }
+}
+
+/* Image load/store and framebuffers without attachment are core since OpenGL 4.3 */
+static bool supportsImageAtomics()
+{
+    GLint major = 0, minor = 0;
+    GLCHECK(glGetIntegerv(GL_MAJOR_VERSION, &major));
+    GLCHECK(glGetIntegerv(GL_MINOR_VERSION, &minor));
+    return major > 4 || (major == 4 && minor >= 3);
+}
+
+Voxelizer::Voxelizer(Backend backend, GPUMethod gpuMethod):
+            _backend(backend),
+            _gpuMethod(GPUMethod::Projections),
             _nbVoxels(0u, 0u, 0u),
             _minCorner(0.f, 0.f, 0.f),
             _maxCorner(0.f, 0.f, 0.f),
-            _framebufferId(-1)
+            _partOrigin(0u, 0u, 0u),
+            _wholeMinCorner(0.f, 0.f, 0.f),
+            _hasRegion(false),
+            _regionMin(0.f, 0.f, 0.f),
+            _regionMax(0.f, 0.f, 0.f),
+            _meshTransform(1.f),
+            _mode(Mode::Surface),
+            _coverage(Coverage::None),
+            _nbCoverageSamples(8),
+            _pyramid(false),
+            _pyramidPending(false),
+            _slabWidth(0),
+            _output(Output::Grid),
+            _gridTextureId(-1),
+            _framebufferId(-1),
+            _emptyVaoId(-1),
+            _readbackBufferId(-1),
+            _readbackBufferSize(0),
+            _readbackNbChannels(1),
+            _nbReadySlabs(0),
+            _readbackSweep(false),
+            _stats(),
+            _gridMatricesBufferId(-1),
+            _gridMatricesTextureId(-1)
 {
+    if (_backend == Backend::CPU)
+        return;
+
     GLCHECK(glGenFramebuffers(1, &_framebufferId));
+    discardFirstTimer();
 
-    /* Shader loading */
-    if (!_sliceShader.loadFromFile("shaders/flatSlice.vert", "shaders/flatSlice.frag")) {
-        std::cerr << "Error: couldn't load flatSlice shader." << std::endl;
-    }
-    if (!_compileShader.loadFromFile("shaders/compileProjections.vert", "shaders/compileProjections.frag")) {
-        std::cerr << "Error: couldn't load compileProjections shader." << std::endl;
+    if (gpuMethod == GPUMethod::Auto)
+        gpuMethod = supportsImageAtomics() ? GPUMethod::ImageAtomics : GPUMethod::Projections;
+
+    if (gpuMethod == GPUMethod::ImageAtomics || gpuMethod == GPUMethod::DominantAxis) {
+        if (loadShaders(gpuMethod)) {
+            _gpuMethod = gpuMethod;
+            return;
+        }
+        std::cerr << "Image atomics unavailable, falling back to projections." << std::endl;
+        gpuMethod = GPUMethod::Projections;
     }
+    _gpuMethod = gpuMethod;
+    loadShaders(gpuMethod);
 }
 
 Voxelizer::~Voxelizer()
 {
+    wait();
+    if (_gridTextureId != (GLuint)(-1))
+        releaseTexture(_gridTextureId);
+    releasePyramid();
+    trim();
     if (_framebufferId != (GLuint)(-1)) {
         GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
         GLCHECK(glDeleteFramebuffers(1, &_framebufferId));
     }
 }
 
-void Voxelizer::recompute(MeshRenderable& mesh, unsigned int resolution)
+Voxelizer::Backend Voxelizer::backend() const
 {
-    computeGridSize(mesh, resolution);
+    return _backend;
+}
 
-    _voxels.resize(_nbVoxels.x * _nbVoxels.y * _nbVoxels.z / 32, 0u);
-    std::fill(_voxels.begin(), _voxels.end(), 0u);
+Voxelizer::GPUMethod Voxelizer::gpuMethod() const
+{
+    return _gpuMethod;
+}
 
-    computeVoxels(mesh);
+bool Voxelizer::usesImageAtomics() const
+{
+    return _gpuMethod == GPUMethod::ImageAtomics || _gpuMethod == GPUMethod::DominantAxis;
 }
 
-void Voxelizer::computeGridSize(MeshRenderable const& mesh, unsigned int resolution)
+void Voxelizer::setRegion(glm::vec3 const& minCorner, glm::vec3 const& maxCorner)
 {
-    glm::vec3 minCoords = glm::vec3(std::numeric_limits<float>::max());
-    glm::vec3 maxCoords = glm::vec3(std::numeric_limits<float>::min());
-    for (glm::vec3 const& v : mesh.vertices()) {
-        minCoords  = glm::min(minCoords, v);
-        maxCoords  = glm::max(maxCoords, v);
-    }
+    _hasRegion = true;
+    _regionMin = glm::min(minCorner, maxCorner);
+    _regionMax = glm::max(minCorner, maxCorner);
+}
 
-    glm::vec3 boundingBoxSize = maxCoords - minCoords;
-    glm::vec3 boundingBoxCenter = 0.5f * (maxCoords + minCoords);
+void Voxelizer::clearRegion()
+{
+    _hasRegion = false;
+}
 
-    float smallestSide = std::min(boundingBoxSize.x, std::min(boundingBoxSize.y, boundingBoxSize.z));
-    _voxelSize = smallestSide / (float)resolution;
+void Voxelizer::setCoverage(Coverage coverage, unsigned int nbSamples)
+{
+    _coverage = coverage;
+    _nbCoverageSamples = std::max(1u, nbSamples);
+}
 
-    _nbVoxels = boundingBoxSize / _voxelSize;
-    _nbVoxels.x = makeMultipleOf32(_nbVoxels.x);
-    _nbVoxels.y = makeMultipleOf32(_nbVoxels.y);
-    _nbVoxels.z = makeMultipleOf32(_nbVoxels.z);
+Voxelizer::Coverage Voxelizer::coverage() const
+{
+    return _coverage;
+}
 
-    _minCorner = boundingBoxCenter - 0.5f * glm::vec3(_nbVoxels) * _voxelSize;
-    _maxCorner = boundingBoxCenter + 0.5f * glm::vec3(_nbVoxels) * _voxelSize;
+std::vector<uint8_t> const& Voxelizer::coverageGrid() const
+{
+    return _coverageGrid;
 }
 
-void Voxelizer::computeVoxels(MeshRenderable& mesh)
+void Voxelizer::setSlabWidth(unsigned int width)
 {
-    if (_framebufferId == (GLuint)(-1)) {
-        std::cerr << "Voxels couldn't be computed: invalid framebuffer." << std::endl;
-        return;
+    _slabWidth = (width == 0) ? 0 : ((width >= 128) ? 128 : ((width >= 64) ? 64 : 32));
+}
+
+unsigned int Voxelizer::slabWidth() const
+{
+    return _slabWidth;
+}
+
+void Voxelizer::setOutput(Output output)
+{
+    _output = output;
+}
+
+Voxelizer::Output Voxelizer::output() const
+{
+    return _output;
+}
+
+GLuint Voxelizer::gridTexture() const
+{
+    return _gridTextureId;
+}
+
+void Voxelizer::setPyramid(bool pyramid)
+{
+    _pyramid = pyramid;
+}
+
+bool Voxelizer::pyramid() const
+{
+    return _pyramid;
+}
+
+unsigned int Voxelizer::nbPyramidLevels() const
+{
+    return _pyramidSizes.size();
+}
+
+glm::uvec3 const& Voxelizer::pyramidLevelSize(unsigned int level) const
+{
+    return _pyramidSizes[level];
+}
+
+std::vector<uint32_t> const& Voxelizer::pyramidLevel(unsigned int level) const
+{
+    static const std::vector<uint32_t> empty;
+    if (level == 0)
+        return _voxels;
+    return (level <= _pyramidLevels.size()) ? _pyramidLevels[level - 1] : empty;
+}
+
+GLuint Voxelizer::pyramidTexture(unsigned int level) const
+{
+    if (level == 0)
+        return _gridTextureId;
+    return (level <= _pyramidTextureIds.size()) ? _pyramidTextureIds[level - 1] : (GLuint)(-1);
+}
+
+bool Voxelizer::loadShaders(GPUMethod method)
+{
+    bool success = true;
+    if (!_gridTextureShader.loadFromFile("shaders/compileProjections.vert", "shaders/gridTexture.frag")) {
+        std::cerr << "Error: couldn't load gridTexture shader." << std::endl;
+        success = false;
     }
-    if (!_sliceShader.isValid() || !_compileShader.isValid()) {
-        std::cerr << "Voxels couldn't be computed: invalid shader." << std::endl;
-        return;
+    if (!_coverageShader.loadFromFile("shaders/compileProjections.vert", "shaders/coverage.frag")) {
+        std::cerr << "Error: couldn't load coverage shader." << std::endl;
+        success = false;
+    }
+    if (!_pyramidShader.loadFromFile("shaders/compileProjections.vert", "shaders/pyramid.frag")) {
+        std::cerr << "Error: couldn't load pyramid shader." << std::endl;
+        success = false;
+    }
+    if (!_sliceShader.loadFromFile("shaders/flatSlice.vert", "shaders/flatSlice.frag")) {
+        std::cerr << "Error: couldn't load flatSlice shader." << std::endl;
+        success = false;
+    }
+    if (!_solidSliceShader.loadFromFile("shaders/solidSlice.vert", "shaders/solidSlice.frag")) {
+        std::cerr << "Error: couldn't load solidSlice shader." << std::endl;
+        success = false;
+    }
+    if (method == GPUMethod::ImageAtomics || method == GPUMethod::DominantAxis) {
+        if (!_flatImageShader.loadFromFile("shaders/flatSlice.vert", "shaders/dominantAxis.geom", "shaders/flatImage.frag")) {
+            std::cerr << "Error: couldn't load flatImage shader." << std::endl;
+            success = false;
+        }
+        if (!_conservativeImageShader.loadFromFile("shaders/flatSlice.vert", "shaders/dominantAxis.geom", "shaders/conservativeImage.frag")) {
+            std::cerr << "Error: couldn't load conservativeImage shader." << std::endl;
+            success = false;
+        }
+        if (!_solidImageShader.loadFromFile("shaders/solidSlice.vert", "shaders/solidImage.frag")) {
+            std::cerr << "Error: couldn't load solidImage shader." << std::endl;
+            success = false;
+        }
+        if (!_instancedFlatImageShader.loadFromFile("shaders/instancedSlice.vert", "shaders/dominantAxis.geom", "shaders/flatImage.frag")) {
+            std::cerr << "Error: couldn't load instancedFlatImage shader." << std::endl;
+            success = false;
+        }
+        if (!_instancedConservativeImageShader.loadFromFile("shaders/instancedSlice.vert", "shaders/dominantAxis.geom", "shaders/conservativeImage.frag")) {
+            std::cerr << "Error: couldn't load instancedConservativeImage shader." << std::endl;
+            success = false;
+        }
+        if (!_instancedSolidImageShader.loadFromFile("shaders/instancedSlice.vert", "shaders/solidImage.frag")) {
+            std::cerr << "Error: couldn't load instancedSolidImage shader." << std::endl;
+            success = false;
+        }
+        return success;
     }
 
-    /* Saving current state for later restoration */
-    const glm::mat4 modelMatrix = mesh.modelMatrix();
-    GLint previousFramebufferId;
-    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+    if (method == GPUMethod::LayeredProjections &&
+        !_layeredSliceShader.loadFromFile("shaders/flatSlice.vert", "shaders/layeredSlice.geom", "shaders/flatSlice.frag")) {
+        std::cerr << "Error: couldn't load layeredSlice shader." << std::endl;
+        success = false;
+    }
+    if (!_conservativeSliceShader.loadFromFile("shaders/flatSlice.vert", "shaders/conservativeSlice.geom", "shaders/conservativeSlice.frag")) {
+        std::cerr << "Error: couldn't load conservativeSlice shader." << std::endl;
+        success = false;
+    }
+    if (!_compileShader.loadFromFile("shaders/compileProjections.vert", "shaders/compileProjections.frag")) {
+        std::cerr << "Error: couldn't load compileProjections shader." << std::endl;
+        success = false;
+    }
+    return success;
+}
 
-    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId));
-    GLenum drawBuffers[1] = {GL_COLOR_ATTACHMENT0};
-    GLCHECK(glDrawBuffers(1, drawBuffers));
+void Voxelizer::recompute(MeshRenderable& mesh, unsigned int resolution, Mode mode)
+{
+    recomputeAsync(mesh, resolution, mode);
+    wait();
+}
 
-    ShaderProgram::bind(_sliceShader);
-    GLCHECK(glDisable(GL_DEPTH_TEST));
-    GLCHECK(glDisable(GL_BLEND));
-    GLCHECK(glDisable(GL_CULL_FACE));
-    GLCHECK(glEnable(GL_COLOR_LOGIC_OP));
-    GLCHECK(glLogicOp(GL_OR));
-    //GLCHECK(glEnable(GL_TEXTURE_3D));
-    GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+void Voxelizer::recomputeAsync(MeshRenderable& mesh, unsigned int resolution, Mode mode)
+{
+    if (_backend == Backend::CPU) {
+        recompute(mesh.vertices(), mesh.indices(), resolution, mode);
+        return;
+    }
+    wait();
+    resetStats();
+    if (_gridTextureId != (GLuint)(-1)) {
+        releaseTexture(_gridTextureId);
+        _gridTextureId = -1;
+    }
 
-    /* Allocated bigger than needed to avoid resizing it */
-    std::vector<uint32_t> CPUBuffer(_nbVoxels.x * _nbVoxels.y * _nbVoxels .z / 32);
+    computeGridSize(mesh.vertices(), resolution);
+    _coverageGrid.clear();
+    releasePyramid();
+    _updatedBoxes.clear();
+    _mode = mode;
 
-    /* Textures allocation */
-    GLuint xProjTextureId = 0, yProjTextureId = 0, zProjTextureId = 0;
+    /* Each texture of the computation spans two of the grid dimensions */
+    GLint maxSize = 0;
+    GLCHECK(glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize));
+    if (std::max(_nbVoxels.x, std::max(_nbVoxels.y, _nbVoxels.z)) > (unsigned int)maxSize) {
+        std::cerr << "Voxels couldn't be computed: the grid (" << _nbVoxels.x << "x" << _nbVoxels.y << "x" << _nbVoxels.z
+                  << ") exceeds the maximum 3D texture size (" << maxSize << "), see recomputeTiled." << std::endl;
+        _voxels.clear();
+        endSubmit();
+        return;
+    }
 
-    /* Projection on (Y,Z) planes (X axis)*/
-    allocate3DTexture(xProjTextureId, _nbVoxels.y, _nbVoxels.z, _nbVoxels.x/32);
-    for (unsigned int sliceX = 0 ; sliceX < _nbVoxels.x ; sliceX+=32) {
-        GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, xProjTextureId, 0, sliceX/32));
-        GLCHECK(glViewport(0, 0, _nbVoxels.y, _nbVoxels.z));
-        GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
-        GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+    /* Nothing to read back when the result stays on the GPU */
+    if (_output == Output::Texture) {
+        _voxels.clear();
+    } else {
+        _voxels.resize((std::size_t)_nbVoxels.x * _nbVoxels.y * _nbVoxels.z / 32, 0u);
+        std::fill(_voxels.begin(), _voxels.end(), 0u);
+    }
+    if (_nbVoxels.x == 0) { //empty region
+        endSubmit();
+        return;
+    }
 
-        drawSlice(mesh, Axis::X, sliceX);
+    if (usesImageAtomics()) {
+        computeVoxelsWithImage(mesh, mode);
+    } else {
+        /* Each slab only draws the triangles it may contain */
+        mesh.sortTriangles();
+        computeVoxels(mesh, mode);
     }
 
-    /* Projection on (X,Z) planes (Y axis) */
-    allocate3DTexture(yProjTextureId, _nbVoxels.x, _nbVoxels.z, _nbVoxels.y/32);
-    for (unsigned int sliceY = 0 ; sliceY < _nbVoxels.y ; sliceY+=32) {
-        GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, yProjTextureId, 0, sliceY/32));
-        GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.z));
-        GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
-        GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+    if (_coverage != Coverage::None) {
+        mesh.sortTriangles();
+        computeCoverage(mesh, mode);
+    }
+    startPyramid();
+    endSubmit();
+}
 
-        drawSlice(mesh, Axis::Y, sliceY);
+void Voxelizer::recompute(std::vector<glm::vec3> const& vertices,
+                          std::vector<glm::ivec3> const& triangles,
+                          unsigned int resolution,
+                          Mode mode)
+{
+    if (_backend != Backend::CPU) {
+        std::cerr << "Voxels couldn't be computed: raw geometry needs the CPU backend." << std::endl;
+        return;
     }
 
-    /* Projection on (X,Y) planes (Z axis) */
-    allocate3DTexture(zProjTextureId, _nbVoxels.x, _nbVoxels.y, _nbVoxels.z/32);
-    for (unsigned int sliceZ = 0 ; sliceZ < _nbVoxels.z ; sliceZ+=32) {
-        GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, zProjTextureId, 0, sliceZ/32));
-        GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.y));
-        GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
-        GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+    resetStats();
+    computeGridSize(vertices, resolution);
+    _coverageGrid.clear();
+    releasePyramid();
+    _updatedBoxes.clear();
+    _mode = mode;
 
-        drawSlice(mesh, Axis::Z, sliceZ);
+    _voxels.resize((std::size_t)_nbVoxels.x * _nbVoxels.y * _nbVoxels.z / 32, 0u);
+    std::fill(_voxels.begin(), _voxels.end(), 0u);
+    if (_nbVoxels.x == 0) { //empty region
+        endSubmit();
+        return;
     }
 
-    /* Finally we compile the 3 projection into one, reusing the (X,Y) plane texture */
-    {
-        GLuint vaoId;
-        GLCHECK(glGenVertexArrays(1, &vaoId));
-        GLCHECK(glBindVertexArray(vaoId));
+    computeVoxelsOnCPU(vertices, triangles, mode);
+    startPyramid();
+    endSubmit();
+}
 
-        ShaderProgram::bind(_compileShader);
+void Voxelizer::recomputeTiled(MeshRenderable& mesh, unsigned int resolution, unsigned int tileSize,
+                               TileCallback const& callback, Mode mode)
+{
+    if (_backend == Backend::CPU) {
+        recomputeTiled(mesh.vertices(), mesh.indices(), resolution, tileSize, callback, mode);
+        return;
+    }
+    wait();
+    resetStats();
+    if (_gridTextureId != (GLuint)(-1)) {
+        releaseTexture(_gridTextureId);
+        _gridTextureId = -1;
+    }
 
-        GLuint sliceULoc = _compileShader.getUniformLocation("slice");
-        GLuint gridSizeULoc = _compileShader.getUniformLocation("gridSize");
-        if (sliceULoc == (GLuint)(-1) || gridSizeULoc == (GLuint)(-1))
-            std::cerr << "fjozeijfozei" << std::endl;
-        GLCHECK(glUniform3f(gridSizeULoc, _nbVoxels.x, _nbVoxels.y, _nbVoxels.z));
+    computeGridSize(mesh.vertices(), resolution);
+    _coverageGrid.clear();
+    releasePyramid();
+    if (!usesImageAtomics())
+        mesh.sortTriangles();
 
-        GLuint xProjTexLoc = _compileShader.getUniformLocation("xProjTex");
-        GLuint yProjTexLoc = _compileShader.getUniformLocation("yProjTex");
-        if (xProjTexLoc == (GLuint)(-1) || yProjTexLoc == (GLuint)(-1))
-            std::cerr << "podapfhiizha" << std::endl;
-        GLCHECK(glUniform1i(xProjTexLoc, 0));
-        GLCHECK(glUniform1i(yProjTexLoc, 1));
+    const Output output = _output;
+    _output = Output::Grid;
+    forEachTile(tileSize, callback, [&]() {
+        if (usesImageAtomics())
+            computeVoxelsWithImage(mesh, mode);
+        else
+            computeVoxels(mesh, mode);
+        wait();
+    });
+    _output = output;
+    endSubmit();
+}
 
-        GLCHECK(glActiveTexture(GL_TEXTURE0));
-        GLCHECK(glBindTexture(GL_TEXTURE_3D, xProjTextureId));
-        GLCHECK(glActiveTexture(GL_TEXTURE1));
-        GLCHECK(glBindTexture(GL_TEXTURE_3D, yProjTextureId));
+void Voxelizer::recomputeTiled(std::vector<glm::vec3> const& vertices,
+                               std::vector<glm::ivec3> const& triangles,
+                               unsigned int resolution, unsigned int tileSize,
+                               TileCallback const& callback, Mode mode)
+{
+    if (_backend != Backend::CPU) {
+        std::cerr << "Voxels couldn't be computed: raw geometry needs the CPU backend." << std::endl;
+        return;
+    }
 
-        for (unsigned int sliceZ = 0 ; sliceZ < _nbVoxels.z ; sliceZ+=32) {
-            GLCHECK(glUniform1ui(sliceULoc, sliceZ));
+    resetStats();
+    computeGridSize(vertices, resolution);
+    releasePyramid();
+    forEachTile(tileSize, callback, [&]() {
+        computeVoxelsOnCPU(vertices, triangles, mode);
+    });
+    endSubmit();
+}
 
-            GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, zProjTextureId, 0, sliceZ/32));
-            GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.y));
-            GLCHECK(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
-        }
+void Voxelizer::recomputeTransformed(MeshRenderable& mesh, std::vector<glm::mat4> const& transforms, unsigned int resolution,
+                                     TransformCallback const& callback, Mode mode)
+{
+    if (_backend == Backend::CPU) {
+        recomputeTransformed(mesh.vertices(), mesh.indices(), transforms, resolution, callback, mode);
+        return;
+    }
+    wait();
+    resetStats();
+    if (_gridTextureId != (GLuint)(-1)) {
+        releaseTexture(_gridTextureId);
+        _gridTextureId = -1;
+    }
 
-        ShaderProgram::unbind();
+    std::vector<glm::vec3> minCorners;
+    computeTransformedGridSizes(mesh.vertices(), transforms, resolution, minCorners);
+    _coverageGrid.clear();
+    releasePyramid();
 
-        GLCHECK(glDeleteVertexArrays(1, &vaoId));
+    const Output output = _output;
+    _output = Output::Grid;
+    if (usesImageAtomics()) {
+        computeTransformedVoxelsWithImage(mesh, transforms, minCorners, callback, mode);
+    } else {
+        /* The triangles are sorted in the mesh coordinates, which the slabs no longer follow: drawSlice draws them all */
+        for (std::size_t iT = 0 ; iT < transforms.size() ; ++iT) {
+            selectTransformedGrid(minCorners[iT]);
+            _meshTransform = transforms[iT];
+            computeVoxels(mesh, mode);
+            wait();
+            callback(iT, _voxels);
+        }
+        _meshTransform = glm::mat4(1.f);
     }
+    _output = output;
 
-    /* Lastly, retreieve the result */
-    GLCHECK(glBindTexture(GL_TEXTURE_3D, zProjTextureId));
-    GLCHECK(glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT_8_8_8_8, _voxels.data()));
+    _voxels.clear();
+    _voxels.shrink_to_fit();
+    endSubmit();
+}
 
-    /* Textures desallocation */
-    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
-    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
-    GLCHECK(glDeleteTextures(1, &xProjTextureId));
-    GLCHECK(glDeleteTextures(1, &yProjTextureId));
-    GLCHECK(glDeleteTextures(1, &zProjTextureId));
+void Voxelizer::recomputeTransformed(std::vector<glm::vec3> const& vertices,
+                                     std::vector<glm::ivec3> const& triangles,
+                                     std::vector<glm::mat4> const& transforms, unsigned int resolution,
+                                     TransformCallback const& callback, Mode mode)
+{
+    if (_backend != Backend::CPU) {
+        std::cerr << "Voxels couldn't be computed: raw geometry needs the CPU backend." << std::endl;
+        return;
+    }
 
-    /* Restoring previous state */
-    GLCHECK(glDisable(GL_COLOR_LOGIC_OP));
+    resetStats();
+    std::vector<glm::vec3> minCorners;
+    computeTransformedGridSizes(vertices, transforms, resolution, minCorners);
+    _coverageGrid.clear();
+    releasePyramid();
 
-    ShaderProgram::unbind();
+    std::vector<glm::vec3> transformed(vertices.size());
+    for (std::size_t iT = 0 ; iT < transforms.size() ; ++iT) {
+        for (std::size_t iV = 0 ; iV < vertices.size() ; ++iV)
+            transformed[iV] = glm::vec3(transforms[iT] * glm::vec4(vertices[iV], 1.f));
 
-    mesh.modelMatrix() = modelMatrix;
-    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+        selectTransformedGrid(minCorners[iT]);
+        computeVoxelsOnCPU(transformed, triangles, mode);
+        callback(iT, _voxels);
+    }
+
+    _voxels.clear();
+    _voxels.shrink_to_fit();
+    endSubmit();
 }
 
-void Voxelizer::drawSlice(MeshRenderable& mesh, Axis axis, unsigned int slice)
+void Voxelizer::update(MeshRenderable& mesh, std::vector<TriangleChange> const& changes)
 {
-    glm::mat4 viewProj, rot;
+    if (_backend == Backend::CPU) {
+        update(mesh.vertices(), mesh.indices(), changes);
+        return;
+    }
+    wait();
+    resetStats();
+    if (!computeUpdatedBoxes(changes))
+        return;
+    if (!usesImageAtomics())
+        mesh.sortTriangles();
 
-    if (axis == Axis::X) {
-        float x = _minCorner.x + _voxelSize * (float)(slice);
-        viewProj = glm::ortho(_minCorner.y, _maxCorner.y, //left right
-                              _minCorner.z, _maxCorner.z, //bottom top
-                              x, x + 32.f*_voxelSize); //near far
+    const Output output = _output;
+    _output = Output::Grid;
+    forEachUpdatedBox([&]() {
+        if (usesImageAtomics())
+            computeVoxelsWithImage(mesh, _mode);
+        else
+            computeVoxels(mesh, _mode);
+        wait();
+    });
+    _output = output;
+    startPyramid();
+    endSubmit();
+}
 
-        rot = glm::rotate(3.1415f/2.f, glm::vec3(0,0,1));
-        rot = glm::rotate(-3.1415f/2.f, glm::vec3(1,0,0)) * rot;
-    } else if (axis == Axis::Y) {
-        float y = _minCorner.y + _voxelSize * (float)(slice);
-        viewProj = glm::ortho(_minCorner.x, _maxCorner.x, //left right
-                              _minCorner.z, _maxCorner.z, //bottom top
-                              y, y + 32.f*_voxelSize); //near far
+void Voxelizer::update(std::vector<glm::vec3> const& vertices,
+                       std::vector<glm::ivec3> const& triangles,
+                       std::vector<TriangleChange> const& changes)
+{
+    if (_backend != Backend::CPU) {
+        std::cerr << "Voxels couldn't be computed: raw geometry needs the CPU backend." << std::endl;
+        return;
+    }
+    resetStats();
+    if (!computeUpdatedBoxes(changes))
+        return;
 
-        rot = glm::rotate(-3.1415f/2.f, glm::vec3(1,0,0));
-        //rot = glm::rotate(3.1415f, glm::vec3(0,1,0)) * rot;
-    } else { //Z
-        float z = _minCorner.z + _voxelSize * (float)(slice);
-        viewProj = glm::ortho(_minCorner.x, _maxCorner.x, //left right
-                              _minCorner.y, _maxCorner.y, //bottom top
-                              z, z + 32.f*_voxelSize); //near far
+    forEachUpdatedBox([&]() {
+        computeVoxelsOnCPU(vertices, triangles, _mode);
+    });
+    startPyramid();
+    endSubmit();
+}
 
-        rot = glm::rotate(3.1415f, glm::vec3(0,0,1));
-        rot = glm::rotate(3.1415f, glm::vec3(0,1,0)) * rot;
+void Voxelizer::recomputeSparse(MeshRenderable& mesh, unsigned int resolution, SparseGrid& sparse, Mode mode)
+{
+    if (_backend == Backend::CPU) {
+        recomputeSparse(mesh.vertices(), mesh.indices(), resolution, sparse, mode);
+        return;
     }
-    mesh.modelMatrix() = rot;
-
-    GLuint viewProjULoc = _sliceShader.getUniformLocation("viewProjMatrix");
-    if(viewProjULoc != ShaderProgram::nullLocation) {
-        GLCHECK(glUniformMatrix4fv(viewProjULoc, 1, GL_FALSE, glm::value_ptr(viewProj)));
+    wait();
+    resetStats();
+    if (_gridTextureId != (GLuint)(-1)) {
+        releaseTexture(_gridTextureId);
+        _gridTextureId = -1;
+    }
+    if (!startSparse(mesh.vertices(), resolution, sparse, mode)) {
+        endSubmit();
+        return;
     }
 
-    mesh.draw(_sliceShader);
+    std::vector<uint32_t> table;
+    const std::size_t nbBricks = computeOccupiedBricks(mesh.vertices(), mesh.indices(), table, nullptr);
+
+    const Output output = _output;
+    _output = Output::Grid;
+    if (!usesImageAtomics() || !computeSparseVoxelsWithImage(mesh, mode, table, nbBricks, sparse)) {
+        /* Boxes of occupied bricks, each slab only drawing the triangles it may contain */
+        std::vector<Box> boxes;
+        mergeBlocks(table, _nbVoxels / SparseGrid::BRICK_SIZE, boxes);
+        if (!usesImageAtomics())
+            mesh.sortTriangles();
+
+        forEachBox(boxes, [&](Box const& box) {
+            if (usesImageAtomics())
+                computeVoxelsWithImage(mesh, mode);
+            else
+                computeVoxels(mesh, mode);
+            wait();
+            keepBricks(box, sparse);
+        });
+    }
+    _output = output;
+    endSubmit();
 }
 
-glm::uvec3 const& Voxelizer::getNbVoxels() const
+void Voxelizer::recomputeSparse(std::vector<glm::vec3> const& vertices,
+                                std::vector<glm::ivec3> const& triangles,
+                                unsigned int resolution, SparseGrid& sparse, Mode mode)
 {
-    return _nbVoxels;
+    if (_backend != Backend::CPU) {
+        std::cerr << "Voxels couldn't be computed: raw geometry needs the CPU backend." << std::endl;
+        return;
+    }
+    resetStats();
+    if (!startSparse(vertices, resolution, sparse, mode)) {
+        endSubmit();
+        return;
+    }
+
+    std::vector<uint32_t> table;
+    std::vector<std::vector<unsigned int>> brickTriangles;
+    computeOccupiedBricks(vertices, triangles, table, &brickTriangles);
+
+    std::vector<Box> boxes;
+    std::vector<uint32_t> blocks = table;
+    const glm::uvec3 nbBricks = _nbVoxels / SparseGrid::BRICK_SIZE;
+    mergeBlocks(blocks, nbBricks, boxes);
+
+    /* Each box only voxelizes the triangles of its bricks, once each */
+    std::vector<glm::ivec3> boxTriangles;
+    std::vector<std::size_t> lastBox(triangles.size(), boxes.size());
+    std::size_t iBox = 0;
+    forEachBox(boxes, [&](Box const& box) {
+        boxTriangles.clear();
+        const glm::uvec3 first = box.origin / SparseGrid::BRICK_SIZE;
+        const glm::uvec3 last = first + box.size / SparseGrid::BRICK_SIZE;
+        for (unsigned int iZ = first.z ; iZ < last.z ; ++iZ) {
+            for (unsigned int iY = first.y ; iY < last.y ; ++iY) {
+                for (unsigned int iX = first.x ; iX < last.x ; ++iX) {
+                    const uint32_t index = table[((std::size_t)iZ * nbBricks.y + iY) * nbBricks.x + iX];
+                    for (unsigned int iT : brickTriangles[index - 1]) {
+                        if (lastBox[iT] != iBox) {
+                            lastBox[iT] = iBox;
+                            boxTriangles.push_back(triangles[iT]);
+                        }
+                    }
+                }
+            }
+        }
+        ++iBox;
+
+        computeVoxelsOnCPU(vertices, boxTriangles, mode);
+        keepBricks(box, sparse);
+    });
+    endSubmit();
 }
 
-float Voxelizer::getVoxelSize() const
+bool Voxelizer::computeUpdatedBoxes(std::vector<TriangleChange> const& changes)
 {
-    return _voxelSize;
+    _updatedBoxes.clear();
+    if (_voxels.size() != (std::size_t)_nbVoxels.x * _nbVoxels.y * _nbVoxels.z / 32 || _nbVoxels.x == 0) {
+        std::cerr << "Voxels couldn't be updated: no previous grid in memory." << std::endl;
+        return false;
+    }
+
+    /* Blocks of 32 voxels overlapped by the triangles, with a margin of one voxel for the rounding errors */
+    const glm::uvec3 nbBlocks = _nbVoxels / 32u;
+    std::vector<uint32_t> changed((std::size_t)nbBlocks.x * nbBlocks.y * nbBlocks.z, 0u);
+    auto blockIndex = [&](unsigned int iX, unsigned int iY, unsigned int iZ) {
+        return ((std::size_t)iZ * nbBlocks.y + iY) * nbBlocks.x + iX;
+    };
+    for (TriangleChange const& change : changes) {
+        glm::vec3 minCoords = change.before[0];
+        glm::vec3 maxCoords = change.before[0];
+        for (unsigned int i = 0 ; i < 3 ; ++i) {
+            minCoords = glm::min(minCoords, glm::min(change.before[i], change.after[i]));
+            maxCoords = glm::max(maxCoords, glm::max(change.before[i], change.after[i]));
+        }
+        const glm::vec3 first = glm::floor((minCoords - _minCorner - _voxelSize) / (32.f * _voxelSize));
+        const glm::vec3 last = glm::floor((maxCoords - _minCorner + _voxelSize) / (32.f * _voxelSize));
+        if (glm::any(glm::lessThan(last, glm::vec3(0.f))) || glm::any(glm::greaterThanEqual(first, glm::vec3(nbBlocks))))
+            continue; //outside of the grid
+
+        const glm::uvec3 firstBlock = glm::uvec3(glm::max(first, glm::vec3(0.f)));
+        const glm::uvec3 lastBlock = glm::min(glm::uvec3(last), nbBlocks - 1u);
+        for (unsigned int iZ = firstBlock.z ; iZ <= lastBlock.z ; ++iZ) {
+            for (unsigned int iY = firstBlock.y ; iY <= lastBlock.y ; ++iY) {
+                for (unsigned int iX = firstBlock.x ; iX <= lastBlock.x ; ++iX)
+                    changed[blockIndex(iX, iY, iZ)] = 1u;
+            }
+        }
+    }
+
+    mergeBlocks(changed, nbBlocks, _updatedBoxes);
+    return true;
 }
 
-glm::vec3 Voxelizer::voxelPosition(unsigned int iX, unsigned int iY, unsigned int iZ) const
+void Voxelizer::forEachUpdatedBox(std::function<void()> const& computeBox)
 {
-    return _minCorner + _voxelSize * glm::vec3(iX,iY,iZ) + .5f * glm::vec3(_voxelSize);
+    std::vector<uint32_t> grid;
+    grid.swap(_voxels);
+    const glm::uvec3 nbVoxels = _nbVoxels;
+
+    forEachBox(_updatedBoxes, [&](Box const& box) {
+        computeBox();
+
+        /* Rows of box.size.x words */
+        for (unsigned int iS = 0 ; iS < box.size.z / 32 ; ++iS) {
+            for (unsigned int iY = 0 ; iY < box.size.y ; ++iY) {
+                const std::size_t from = ((std::size_t)iS * box.size.y + iY) * box.size.x;
+                const std::size_t to = ((std::size_t)(box.origin.z / 32 + iS) * nbVoxels.y + box.origin.y + iY) * nbVoxels.x + box.origin.x;
+                std::copy(_voxels.begin() + from, _voxels.begin() + from + box.size.x, grid.begin() + to);
+            }
+        }
+        if (_gridTextureId != (GLuint)(-1)) {
+            GLCHECK(glBindTexture(GL_TEXTURE_3D, _gridTextureId));
+            GLCHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+            GLCHECK(glTexSubImage3D(GL_TEXTURE_3D, 0, box.origin.x, box.origin.y, box.origin.z / 32,
+                                    box.size.x, box.size.y, box.size.z / 32, GL_RED_INTEGER, GL_UNSIGNED_INT, _voxels.data()));
+            GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+        }
+    });
+
+    _voxels.swap(grid);
+}
+
+void Voxelizer::forEachBox(std::vector<Box> const& boxes, std::function<void(Box const&)> const& computeBox)
+{
+    /* Each box temporarily becomes the grid, with its own corners, like the tiles */
+    const glm::uvec3 nbVoxels = _nbVoxels;
+    const glm::vec3 minCorner = _minCorner;
+    const glm::vec3 maxCorner = _maxCorner;
+
+    _wholeMinCorner = minCorner;
+    for (Box const& box : boxes) {
+        _nbVoxels = box.size;
+        _partOrigin = box.origin;
+        _minCorner = minCorner + _voxelSize * glm::vec3(box.origin);
+        _maxCorner = _minCorner + _voxelSize * glm::vec3(box.size);
+        _voxels.assign((std::size_t)box.size.x * box.size.y * box.size.z / 32, 0u);
+
+        computeBox(box);
+    }
+
+    _partOrigin = glm::uvec3(0u);
+    _nbVoxels = nbVoxels;
+    _minCorner = minCorner;
+    _maxCorner = maxCorner;
+    _voxels.clear();
+    _voxels.shrink_to_fit();
+}
+
+bool Voxelizer::startSparse(std::vector<glm::vec3> const& vertices, unsigned int resolution, SparseGrid& sparse, Mode mode)
+{
+    if (mode == Mode::Solid) {
+        std::cerr << "Voxels couldn't be computed: the solid mode isn't sparse." << std::endl;
+        sparse.reset(glm::uvec3(0u), glm::vec3(0.f), 0.f);
+        return false;
+    }
+
+    computeGridSize(vertices, resolution);
+    _coverageGrid.clear();
+    releasePyramid();
+    _updatedBoxes.clear();
+    _voxels.clear();
+    _voxels.shrink_to_fit();
+
+    sparse.reset(_nbVoxels, _minCorner, _voxelSize);
+    return _nbVoxels.x != 0; //empty region
+}
+
+std::size_t Voxelizer::computeOccupiedBricks(std::vector<glm::vec3> const& vertices, std::vector<glm::ivec3> const& triangles,
+                                             std::vector<uint32_t>& table,
+                                             std::vector<std::vector<unsigned int>>* brickTriangles)
+{
+    const glm::uvec3 nbBricks = _nbVoxels / SparseGrid::BRICK_SIZE;
+    table.assign((std::size_t)nbBricks.x * nbBricks.y * nbBricks.z, 0u);
+    if (brickTriangles)
+        brickTriangles->clear();
+
+    /* Triangle/brick overlap, in brick units. The bricks are grown by one voxel on each side,
+     * so that the fine passes, which may set voxels next to the exact overlap, find their brick. */
+    const float brickSize = SparseGrid::BRICK_SIZE * _voxelSize;
+    const float margin = 1.f / SparseGrid::BRICK_SIZE;
+    std::size_t nbOccupied = 0;
+    for (std::size_t iT = 0 ; iT < triangles.size() ; ++iT) {
+        glm::ivec3 const& t = triangles[iT];
+        CPUVoxelization::TriangleBoxTest test((vertices[t.x] - _minCorner) / brickSize,
+                                              (vertices[t.y] - _minCorner) / brickSize,
+                                              (vertices[t.z] - _minCorner) / brickSize);
+        for (unsigned int i = 0 ; i < 13 ; ++i) {
+            const glm::vec3& a = test.axes[i];
+            const float radius = margin * (std::abs(a.x) + std::abs(a.y) + std::abs(a.z));
+            test.lo[i] -= radius;
+            test.hi[i] += radius;
+        }
+
+        const glm::vec3 first = glm::floor(test.minCoords - margin);
+        const glm::vec3 last = glm::floor(test.maxCoords + margin);
+        if (glm::any(glm::lessThan(last, glm::vec3(0.f))) || glm::any(glm::greaterThanEqual(first, glm::vec3(nbBricks))))
+            continue; //outside of the grid
+
+        const glm::uvec3 firstBrick = glm::uvec3(glm::max(first, glm::vec3(0.f)));
+        const glm::uvec3 lastBrick = glm::min(glm::uvec3(last), nbBricks - 1u);
+        for (unsigned int iZ = firstBrick.z ; iZ <= lastBrick.z ; ++iZ) {
+            for (unsigned int iY = firstBrick.y ; iY <= lastBrick.y ; ++iY) {
+                for (unsigned int iX = firstBrick.x ; iX <= lastBrick.x ; ++iX) {
+                    if (!test.overlaps(iX, iY, iZ))
+                        continue;
+
+                    uint32_t& index = table[((std::size_t)iZ * nbBricks.y + iY) * nbBricks.x + iX];
+                    if (index == 0) {
+                        index = ++nbOccupied;
+                        if (brickTriangles)
+                            brickTriangles->emplace_back();
+                    }
+                    if (brickTriangles)
+                        (*brickTriangles)[index - 1].push_back(iT);
+                }
+            }
+        }
+    }
+    return nbOccupied;
+}
+
+void Voxelizer::keepBricks(Box const& box, SparseGrid& sparse) const
+{
+    const unsigned int n = SparseGrid::BRICK_SIZE;
+    glm::uvec3 iB;
+    for (iB.z = 0 ; iB.z < box.size.z / n ; ++iB.z) {
+        for (iB.y = 0 ; iB.y < box.size.y / n ; ++iB.y) {
+            for (iB.x = 0 ; iB.x < box.size.x / n ; ++iB.x) {
+                /* Rows of 32 words, in the box layout */
+                auto row = [&](unsigned int iY) {
+                    return _voxels.begin() + ((std::size_t)iB.z * box.size.y + n * iB.y + iY) * box.size.x + n * iB.x;
+                };
+                bool empty = true;
+                for (unsigned int iY = 0 ; iY < n && empty ; ++iY)
+                    empty = std::all_of(row(iY), row(iY) + n, [](uint32_t word) { return word == 0u; });
+                if (empty)
+                    continue;
+
+                uint32_t* words = sparse.addBrick(box.origin / n + iB);
+                for (unsigned int iY = 0 ; iY < n ; ++iY)
+                    std::copy(row(iY), row(iY) + n, words + iY * n);
+            }
+        }
+    }
+}
+
+void Voxelizer::forEachTile(unsigned int tileSize, TileCallback const& callback, std::function<void()> const& computeTile)
+{
+    _voxels.clear();
+    _updatedBoxes.clear();
+    if (tileSize == 0 || tileSize % 32 != 0) {
+        std::cerr << "Voxels couldn't be computed: the tile size must be a multiple of 32." << std::endl;
+        return;
+    }
+
+    /* The tile temporarily becomes the grid, with its own corners */
+    const glm::uvec3 nbVoxels = _nbVoxels;
+    const glm::vec3 minCorner = _minCorner;
+    const glm::vec3 maxCorner = _maxCorner;
+
+    _wholeMinCorner = minCorner;
+    glm::uvec3 origin;
+    for (origin.z = 0 ; origin.z < nbVoxels.z ; origin.z += tileSize) {
+        for (origin.y = 0 ; origin.y < nbVoxels.y ; origin.y += tileSize) {
+            for (origin.x = 0 ; origin.x < nbVoxels.x ; origin.x += tileSize) {
+                const glm::uvec3 tileSize3 = glm::min(glm::uvec3(tileSize), nbVoxels - origin);
+                _nbVoxels = tileSize3;
+                _partOrigin = origin;
+                _minCorner = minCorner + _voxelSize * glm::vec3(origin);
+                _maxCorner = _minCorner + _voxelSize * glm::vec3(tileSize3);
+                _voxels.assign((std::size_t)tileSize3.x * tileSize3.y * tileSize3.z / 32, 0u);
+
+                computeTile();
+
+                _partOrigin = glm::uvec3(0u);
+                _nbVoxels = nbVoxels;
+                _minCorner = minCorner;
+                _maxCorner = maxCorner;
+                callback(origin, tileSize3, _voxels);
+            }
+        }
+    }
+
+    _voxels.clear();
+    _voxels.shrink_to_fit();
+}
+
+void Voxelizer::computeVoxelsOnCPU(std::vector<glm::vec3> const& vertices, std::vector<glm::ivec3> const& triangles, Mode mode)
+{
+    /* Out of the tiles and boxes, the part is the whole grid */
+    const glm::vec3 minCorner = (_partOrigin == glm::uvec3(0u)) ? _minCorner : _wholeMinCorner;
+    if (mode == Mode::Solid) {
+        CPUVoxelization::voxelizeSolid(vertices, triangles, minCorner, _voxelSize, _nbVoxels, _partOrigin, _voxels);
+        return;
+    }
+
+    const CPUVoxelization::Separability separability = (mode == Mode::Conservative26) ?
+                CPUVoxelization::Separability::TwentySix : CPUVoxelization::Separability::Six;
+    CPUVoxelization::voxelize(vertices, triangles, minCorner, _voxelSize, _nbVoxels, _partOrigin, _voxels, separability);
+}
+
+/* The grid fitting the bounding box, resolution voxels along its smallest side, each side rounded up to a multiple of 32 */
+static glm::uvec3 fitGrid(glm::vec3 const& boundingBoxSize, unsigned int resolution, float& voxelSize)
+{
+    float smallestSide = std::min(boundingBoxSize.x, std::min(boundingBoxSize.y, boundingBoxSize.z));
+    voxelSize = smallestSide / (float)resolution;
+
+    glm::uvec3 nbVoxels = boundingBoxSize / voxelSize;
+    nbVoxels.x = makeMultipleOf32(nbVoxels.x);
+    nbVoxels.y = makeMultipleOf32(nbVoxels.y);
+    nbVoxels.z = makeMultipleOf32(nbVoxels.z);
+    return nbVoxels;
+}
+
+static void boundingBox(std::vector<glm::vec3> const& vertices, glm::vec3& minCoords, glm::vec3& maxCoords)
+{
+    minCoords = glm::vec3(std::numeric_limits<float>::max());
+    maxCoords = glm::vec3(std::numeric_limits<float>::lowest());
+    for (glm::vec3 const& v : vertices) {
+        minCoords  = glm::min(minCoords, v);
+        maxCoords  = glm::max(maxCoords, v);
+    }
+}
+
+glm::uvec3 Voxelizer::gridSize(std::vector<glm::vec3> const& vertices, unsigned int resolution)
+{
+    glm::vec3 minCoords, maxCoords;
+    boundingBox(vertices, minCoords, maxCoords);
+    float voxelSize;
+    return fitGrid(maxCoords - minCoords, resolution, voxelSize);
+}
+
+void Voxelizer::computeGridSize(std::vector<glm::vec3> const& vertices, unsigned int resolution)
+{
+    glm::vec3 minCoords, maxCoords;
+    boundingBox(vertices, minCoords, maxCoords);
+
+    glm::vec3 boundingBoxSize = maxCoords - minCoords;
+    glm::vec3 boundingBoxCenter = 0.5f * (maxCoords + minCoords);
+
+    _nbVoxels = fitGrid(boundingBoxSize, resolution, _voxelSize);
+
+    _minCorner = boundingBoxCenter - 0.5f * glm::vec3(_nbVoxels) * _voxelSize;
+    _maxCorner = boundingBoxCenter + 0.5f * glm::vec3(_nbVoxels) * _voxelSize;
+
+    /* The region is snapped to the 32 voxels blocks of the whole grid */
+    if (_hasRegion) {
+        const glm::vec3 first = glm::floor((_regionMin - _minCorner) / (32.f * _voxelSize));
+        const glm::vec3 last = glm::ceil((_regionMax - _minCorner) / (32.f * _voxelSize));
+        const glm::uvec3 firstVoxel = 32u * glm::uvec3(glm::clamp(first, glm::vec3(0.f), glm::vec3(_nbVoxels / 32u)));
+        const glm::uvec3 lastVoxel = 32u * glm::uvec3(glm::clamp(last, glm::vec3(0.f), glm::vec3(_nbVoxels / 32u)));
+
+        _nbVoxels = lastVoxel - firstVoxel;
+        if (_nbVoxels.x == 0 || _nbVoxels.y == 0 || _nbVoxels.z == 0)
+            _nbVoxels = glm::uvec3(0u);
+        _minCorner += _voxelSize * glm::vec3(firstVoxel);
+        _maxCorner = _minCorner + _voxelSize * glm::vec3(_nbVoxels);
+    }
+}
+
+void Voxelizer::computeTransformedGridSizes(std::vector<glm::vec3> const& vertices, std::vector<glm::mat4> const& transforms,
+                                            unsigned int resolution, std::vector<glm::vec3>& minCorners)
+{
+    /* The voxel size doesn't depend on the transform, so that the grids can be compared */
+    glm::vec3 minCoords = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 maxCoords = glm::vec3(std::numeric_limits<float>::lowest());
+    for (glm::vec3 const& v : vertices) {
+        minCoords  = glm::min(minCoords, v);
+        maxCoords  = glm::max(maxCoords, v);
+    }
+    const glm::vec3 boundingBoxSize = maxCoords - minCoords;
+    const float smallestSide = std::min(boundingBoxSize.x, std::min(boundingBoxSize.y, boundingBoxSize.z));
+    _voxelSize = smallestSide / (float)resolution;
+
+    /* One size for all the grids, so that they share the same textures */
+    std::vector<glm::vec3> centers(transforms.size());
+    _nbVoxels = glm::uvec3(0u);
+    for (std::size_t iT = 0 ; iT < transforms.size() ; ++iT) {
+        minCoords = glm::vec3(std::numeric_limits<float>::max());
+        maxCoords = glm::vec3(std::numeric_limits<float>::lowest());
+        for (glm::vec3 const& v : vertices) {
+            const glm::vec3 p = glm::vec3(transforms[iT] * glm::vec4(v, 1.f));
+            minCoords  = glm::min(minCoords, p);
+            maxCoords  = glm::max(maxCoords, p);
+        }
+        centers[iT] = 0.5f * (maxCoords + minCoords);
+
+        const glm::uvec3 nbVoxels = glm::uvec3((maxCoords - minCoords) / _voxelSize);
+        _nbVoxels.x = std::max(_nbVoxels.x, makeMultipleOf32(nbVoxels.x));
+        _nbVoxels.y = std::max(_nbVoxels.y, makeMultipleOf32(nbVoxels.y));
+        _nbVoxels.z = std::max(_nbVoxels.z, makeMultipleOf32(nbVoxels.z));
+    }
+
+    minCorners.resize(transforms.size());
+    for (std::size_t iT = 0 ; iT < transforms.size() ; ++iT)
+        minCorners[iT] = centers[iT] - 0.5f * glm::vec3(_nbVoxels) * _voxelSize;
+}
+
+void Voxelizer::selectTransformedGrid(glm::vec3 const& minCorner)
+{
+    _updatedBoxes.clear();
+    _minCorner = minCorner;
+    _maxCorner = minCorner + _voxelSize * glm::vec3(_nbVoxels);
+    _voxels.assign((std::size_t)_nbVoxels.x * _nbVoxels.y * _nbVoxels.z / 32, 0u);
+}
+
+void Voxelizer::computeVoxels(MeshRenderable& mesh, Mode mode)
+{
+    if (_framebufferId == (GLuint)(-1)) {
+        std::cerr << "Voxels couldn't be computed: invalid framebuffer." << std::endl;
+        return;
+    }
+    const bool conservative = (mode == Mode::Conservative6 || mode == Mode::Conservative26);
+    const bool solid = (mode == Mode::Solid);
+    /* On llvmpipe 128 layers take solid mode at 256 from 234 to 124 ms, but surface mode from 1076 to 2250 ms:
+     * the merge pass fetches the RGBA32UI texels much slower than R32UI ones */
+    const unsigned int width = (_slabWidth != 0) ? _slabWidth : (solid ? 128 : 32);
+    /* Deeper grids fall back to the slab by slab draws, a triangle could overlap more slabs than the geometry shader can emit */
+    const glm::uvec3 nbSlabs = (_nbVoxels + glm::uvec3(width - 1)) / width;
+    const bool layered = (mode == Mode::Surface && _gpuMethod == GPUMethod::LayeredProjections && _layeredSliceShader.isValid() &&
+                          glm::all(glm::lessThanEqual(nbSlabs, glm::uvec3(MAX_LAYERED_SLABS))));
+    ShaderProgram& sliceShader = solid ? _solidSliceShader :
+                                 (conservative ? _conservativeSliceShader : (layered ? _layeredSliceShader : _sliceShader));
+    if (!sliceShader.isValid() || !_compileShader.isValid()) {
+        std::cerr << "Voxels couldn't be computed: invalid shader." << std::endl;
+        return;
+    }
+
+    /* Saving current state for later restoration */
+    const glm::mat4 modelMatrix = mesh.modelMatrix();
+    GLint previousFramebufferId;
+    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId));
+    GLenum drawBuffers[1] = {GL_COLOR_ATTACHMENT0};
+    GLCHECK(glDrawBuffers(1, drawBuffers));
+
+    ShaderProgram::bind(sliceShader);
+    GLuint separabilityULoc = sliceShader.getUniformLocation("separability");
+    if (separabilityULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1ui(separabilityULoc, (mode == Mode::Conservative6) ? 6u : 26u));
+    }
+    GLuint slabWidthULoc = sliceShader.getUniformLocation("slabWidth");
+    if (slabWidthULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1ui(slabWidthULoc, width));
+    }
+    GLuint viewportSizeULoc = sliceShader.getUniformLocation("viewportSize");
+    GLuint firstLayerULoc = sliceShader.getUniformLocation("firstLayer");
+    GLuint nbLayersULoc = sliceShader.getUniformLocation("nbLayers");
+    if (nbLayersULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1f(nbLayersULoc, _nbVoxels.z));
+    }
+
+    GLCHECK(glDisable(GL_DEPTH_TEST));
+    GLCHECK(glDisable(GL_BLEND));
+    GLCHECK(glDisable(GL_CULL_FACE));
+    GLCHECK(glEnable(GL_COLOR_LOGIC_OP));
+    GLCHECK(glLogicOp(solid ? GL_XOR : GL_OR));
+    //GLCHECK(glEnable(GL_TEXTURE_3D));
+    GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+
+    /* Textures allocation, the X and Y projections are useless in solid mode.
+     * Each texel holds a slab of width layers, the last slab may go beyond the grid. */
+    const unsigned int nbChannels = width / 32;
+    const GLenum format = slabFormat(nbChannels);
+    GLuint xProjTextureId = 0, yProjTextureId = 0, zProjTextureId = 0;
+    if (!solid) {
+        xProjTextureId = acquireTexture(format, glm::uvec3(_nbVoxels.y, _nbVoxels.z, nbSlabs.x));
+        yProjTextureId = acquireTexture(format, glm::uvec3(_nbVoxels.x, _nbVoxels.z, nbSlabs.y));
+    }
+    zProjTextureId = acquireTexture(format, glm::uvec3(_nbVoxels.x, _nbVoxels.y, nbSlabs.z));
+
+    /* Projection on (Y,Z) planes (X axis)*/
+    if (!solid)
+        beginTimer(&Stats::xProjection);
+    if (layered)
+        drawLayers(mesh, Axis::X, xProjTextureId, _nbVoxels.y, _nbVoxels.z, _nbVoxels.x, width);
+    for (unsigned int sliceX = 0 ; sliceX < _nbVoxels.x && !solid && !layered ; sliceX+=width) {
+        GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, xProjTextureId, 0, sliceX/width));
+        GLCHECK(glViewport(0, 0, _nbVoxels.y, _nbVoxels.z));
+        GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
+        GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+        if (viewportSizeULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform2f(viewportSizeULoc, _nbVoxels.y, _nbVoxels.z));
+        }
+
+        drawSlice(mesh, sliceShader, Axis::X, sliceX, width);
+    }
+    if (!solid)
+        endTimer();
+
+    /* Projection on (X,Z) planes (Y axis) */
+    if (!solid)
+        beginTimer(&Stats::yProjection);
+    if (layered)
+        drawLayers(mesh, Axis::Y, yProjTextureId, _nbVoxels.x, _nbVoxels.z, _nbVoxels.y, width);
+    for (unsigned int sliceY = 0 ; sliceY < _nbVoxels.y && !solid && !layered ; sliceY+=width) {
+        GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, yProjTextureId, 0, sliceY/width));
+        GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.z));
+        GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
+        GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+        if (viewportSizeULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform2f(viewportSizeULoc, _nbVoxels.x, _nbVoxels.z));
+        }
+
+        drawSlice(mesh, sliceShader, Axis::Y, sliceY, width);
+    }
+    if (!solid)
+        endTimer();
+
+    /* Projection on (X,Y) planes (Z axis).
+     * In solid mode every pass draws the whole depth range, the fragment shader keeps the layers of the slab. */
+    beginTimer(&Stats::zProjection);
+    if (layered)
+        drawLayers(mesh, Axis::Z, zProjTextureId, _nbVoxels.x, _nbVoxels.y, _nbVoxels.z, width);
+    for (unsigned int sliceZ = 0 ; sliceZ < _nbVoxels.z && !layered ; sliceZ+=width) {
+        GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, zProjTextureId, 0, sliceZ/width));
+        GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.y));
+        GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
+        GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+        if (viewportSizeULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform2f(viewportSizeULoc, _nbVoxels.x, _nbVoxels.y));
+        }
+
+        if (solid) {
+            GLCHECK(glUniform1ui(firstLayerULoc, sliceZ));
+            drawSlice(mesh, sliceShader, Axis::Z, 0, _nbVoxels.z, true);
+        } else {
+            drawSlice(mesh, sliceShader, Axis::Z, sliceZ, width);
+        }
+    }
+    endTimer();
+
+    /* Finally we compile the 3 projection into one, reusing the (X,Y) plane texture */
+    if (!solid) {
+        beginTimer(&Stats::compile);
+        GLCHECK(glBindVertexArray(emptyVAO()));
+
+        ShaderProgram::bind(_compileShader);
+
+        GLuint sliceULoc = _compileShader.getUniformLocation("slice");
+        GLuint gridSizeULoc = _compileShader.getUniformLocation("gridSize");
+        if (sliceULoc == (GLuint)(-1) || gridSizeULoc == (GLuint)(-1))
+            std::cerr << "fjozeijfozei" << std::endl;
+        GLCHECK(glUniform3f(gridSizeULoc, _nbVoxels.x, _nbVoxels.y, _nbVoxels.z));
+        GLuint compileSlabWidthULoc = _compileShader.getUniformLocation("slabWidth");
+        if (compileSlabWidthULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform1ui(compileSlabWidthULoc, width));
+        }
+
+        GLuint xProjTexLoc = _compileShader.getUniformLocation("xProjTex");
+        GLuint yProjTexLoc = _compileShader.getUniformLocation("yProjTex");
+        if (xProjTexLoc == (GLuint)(-1) || yProjTexLoc == (GLuint)(-1))
+            std::cerr << "podapfhiizha" << std::endl;
+        GLCHECK(glUniform1i(xProjTexLoc, 0));
+        GLCHECK(glUniform1i(yProjTexLoc, 1));
+
+        GLCHECK(glActiveTexture(GL_TEXTURE0));
+        GLCHECK(glBindTexture(GL_TEXTURE_3D, xProjTextureId));
+        GLCHECK(glActiveTexture(GL_TEXTURE1));
+        GLCHECK(glBindTexture(GL_TEXTURE_3D, yProjTextureId));
+
+        for (unsigned int sliceZ = 0 ; sliceZ < _nbVoxels.z ; sliceZ+=width) {
+            GLCHECK(glUniform1ui(sliceULoc, sliceZ));
+
+            GLCHECK(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, zProjTextureId, 0, sliceZ/width));
+            GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.y));
+            GLCHECK(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+        }
+
+        ShaderProgram::unbind();
+
+        GLCHECK(glBindVertexArray(0));
+        endTimer();
+    }
+
+    /* Lastly, retreieve the result, asynchronously */
+    if (_output != Output::Grid) {
+        keepGridTexture(zProjTextureId, nbChannels, solid);
+        if (_output == Output::GridAndTexture)
+            startReadback(_gridTextureId, 1, false);
+    } else {
+        startReadback(zProjTextureId, nbChannels, solid);
+    }
+
+    /* Textures go back to the pool */
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
+    if (!solid) {
+        releaseTexture(xProjTextureId);
+        releaseTexture(yProjTextureId);
+    }
+    releaseTexture(zProjTextureId);
+
+    /* Restoring previous state */
+    GLCHECK(glDisable(GL_COLOR_LOGIC_OP));
+
+    ShaderProgram::unbind();
+
+    mesh.modelMatrix() = modelMatrix;
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+}
+
+void Voxelizer::setupImagePass(ShaderProgram& shader, Mode mode)
+{
+    /* Nothing is attached: the framebuffer only defines the rasterization area */
+    const unsigned int maxSide = glm::compMax(_nbVoxels);
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId));
+    GLCHECK(glFramebufferParameteri(GL_FRAMEBUFFER, GL_FRAMEBUFFER_DEFAULT_WIDTH, maxSide));
+    GLCHECK(glFramebufferParameteri(GL_FRAMEBUFFER, GL_FRAMEBUFFER_DEFAULT_HEIGHT, maxSide));
+
+    ShaderProgram::bind(shader);
+    GLuint separabilityULoc = shader.getUniformLocation("separability");
+    if (separabilityULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1ui(separabilityULoc, (mode == Mode::Conservative6) ? 6u : 26u));
+    }
+    GLuint gridSizeULoc = shader.getUniformLocation("gridSize");
+    if (gridSizeULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform3ui(gridSizeULoc, _nbVoxels.x, _nbVoxels.y, _nbVoxels.z));
+    }
+    GLuint slabsPerGridULoc = shader.getUniformLocation("slabsPerGrid");
+    if (slabsPerGridULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1ui(slabsPerGridULoc, _nbVoxels.z / 32));
+    }
+    GLuint conservativeULoc = shader.getUniformLocation("conservative");
+    if (conservativeULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(conservativeULoc, mode == Mode::Conservative6 || mode == Mode::Conservative26));
+    }
+    GLuint dominantOnlyULoc = shader.getUniformLocation("dominantOnly");
+    if (dominantOnlyULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(dominantOnlyULoc, _gpuMethod == GPUMethod::DominantAxis));
+    }
+    GLuint sparseULoc = shader.getUniformLocation("sparse");
+    if (sparseULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(sparseULoc, false));
+    }
+    GLuint nbLayersULoc = shader.getUniformLocation("nbLayers");
+    if (nbLayersULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1f(nbLayersULoc, _nbVoxels.z));
+    }
+    GLuint viewportSizeULoc = shader.getUniformLocation("viewportSize");
+    if (viewportSizeULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform2f(viewportSizeULoc, _nbVoxels.x, _nbVoxels.y));
+    }
+    GLuint viewportSideULoc = shader.getUniformLocation("viewportSide");
+    if (viewportSideULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1f(viewportSideULoc, maxSide));
+    }
+    GLuint viewProjULoc = shader.getUniformLocation("viewProjMatrix");
+    if (viewProjULoc != ShaderProgram::nullLocation) {
+        const glm::mat4 gridMatrix = glm::scale(glm::vec3(1.f / _voxelSize)) * glm::translate(-_minCorner);
+        GLCHECK(glUniformMatrix4fv(viewProjULoc, 1, GL_FALSE, glm::value_ptr(gridMatrix)));
+    }
+
+    GLCHECK(glDisable(GL_DEPTH_TEST));
+    GLCHECK(glDisable(GL_BLEND));
+    GLCHECK(glDisable(GL_CULL_FACE));
+
+    /* Solid mode: the Z projection only. Otherwise positions are given in voxel coordinates to dominantAxis.geom,
+     * which projects them on a square viewport, 1 pixel being 1 voxel. */
+    if (mode == Mode::Solid) {
+        GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.y));
+    } else {
+        GLCHECK(glViewport(0, 0, maxSide, maxSide));
+    }
+}
+
+void Voxelizer::bindClearedImage(GLuint textureId)
+{
+    /* All layers at once, through the framebuffer */
+    const GLuint zero[4] = {0u, 0u, 0u, 0u};
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureId, 0));
+    GLCHECK(glClearBufferuiv(GL_COLOR, 0, zero));
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
+    GLCHECK(glBindImageTexture(0, textureId, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI));
+}
+
+void Voxelizer::computeVoxelsWithImage(MeshRenderable& mesh, Mode mode)
+{
+    if (_framebufferId == (GLuint)(-1)) {
+        std::cerr << "Voxels couldn't be computed: invalid framebuffer." << std::endl;
+        return;
+    }
+    const bool conservative = (mode == Mode::Conservative6 || mode == Mode::Conservative26);
+    const bool solid = (mode == Mode::Solid);
+    ShaderProgram& shader = solid ? _solidImageShader : (conservative ? _conservativeImageShader : _flatImageShader);
+    if (!shader.isValid()) {
+        std::cerr << "Voxels couldn't be computed: invalid shader." << std::endl;
+        return;
+    }
+
+    /* Saving current state for later restoration */
+    const glm::mat4 modelMatrix = mesh.modelMatrix();
+    GLint previousFramebufferId;
+    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+
+    setupImagePass(shader, mode);
+
+    /* The grid itself */
+    const GLuint gridTextureId = acquireTexture(GL_R32UI, glm::uvec3(_nbVoxels.x, _nbVoxels.y, _nbVoxels.z/32));
+    beginTimer(&Stats::imageDraw);
+    bindClearedImage(gridTextureId);
+
+    if (solid) {
+        /* Parity along Z only, the whole depth at once */
+        drawSlice(mesh, shader, Axis::Z, 0, _nbVoxels.z, true);
+    } else {
+        /* A single draw: the geometry shader sends each triangle along its dominant axis (or the three axes, see dominantAxis.geom) */
+        mesh.modelMatrix() = glm::mat4(1.f);
+        mesh.draw(shader);
+    }
+    endTimer();
+
+    /* The image is already in the grid layout */
+    GLCHECK(glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT));
+    GLCHECK(glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI));
+    if (_output == Output::Grid) {
+        startReadback(gridTextureId, 1, solid);
+    } else {
+        /* Only the solid mode still needs a pass */
+        if (solid)
+            keepGridTexture(gridTextureId, 1, true);
+        else
+            _gridTextureId = gridTextureId;
+        if (_output == Output::GridAndTexture)
+            startReadback(_gridTextureId, 1, false);
+    }
+
+    /* Texture goes back to the pool, unless it is the result */
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    if (gridTextureId != _gridTextureId)
+        releaseTexture(gridTextureId);
+
+    /* Restoring previous state */
+    ShaderProgram::unbind();
+
+    mesh.modelMatrix() = modelMatrix;
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+}
+
+void Voxelizer::computeTransformedVoxelsWithImage(MeshRenderable& mesh, std::vector<glm::mat4> const& transforms,
+                                                  std::vector<glm::vec3> const& minCorners,
+                                                  TransformCallback const& callback, Mode mode)
+{
+    if (_framebufferId == (GLuint)(-1)) {
+        std::cerr << "Voxels couldn't be computed: invalid framebuffer." << std::endl;
+        return;
+    }
+    const bool conservative = (mode == Mode::Conservative6 || mode == Mode::Conservative26);
+    const bool solid = (mode == Mode::Solid);
+    ShaderProgram& shader = solid ? _instancedSolidImageShader :
+                                    (conservative ? _instancedConservativeImageShader : _instancedFlatImageShader);
+    if (!shader.isValid()) {
+        std::cerr << "Voxels couldn't be computed: invalid shader." << std::endl;
+        return;
+    }
+    if (transforms.empty() || _nbVoxels.x == 0 || _nbVoxels.y == 0 || _nbVoxels.z == 0)
+        return;
+
+    /* Mesh to voxel coordinates of each grid, uploaded once */
+    std::vector<glm::mat4> gridMatrices(transforms.size());
+    for (std::size_t iT = 0 ; iT < transforms.size() ; ++iT)
+        gridMatrices[iT] = glm::scale(glm::vec3(1.f / _voxelSize)) * glm::translate(-minCorners[iT]) * transforms[iT];
+
+    if (_gridMatricesBufferId == (GLuint)(-1)) {
+        GLCHECK(glGenBuffers(1, &_gridMatricesBufferId));
+        GLCHECK(glGenTextures(1, &_gridMatricesTextureId));
+    }
+    GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, _gridMatricesBufferId));
+    GLCHECK(glBufferData(GL_TEXTURE_BUFFER, gridMatrices.size() * sizeof(glm::mat4), gridMatrices.data(), GL_STREAM_DRAW));
+    GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+    GLCHECK(glActiveTexture(GL_TEXTURE0));
+    GLCHECK(glBindTexture(GL_TEXTURE_BUFFER, _gridMatricesTextureId));
+    GLCHECK(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _gridMatricesBufferId));
+
+    /* The grids of a chunk are stacked along the image depth */
+    const unsigned int slabsPerGrid = _nbVoxels.z / 32;
+    const std::size_t gridBytes = (std::size_t)_nbVoxels.x * _nbVoxels.y * slabsPerGrid * sizeof(uint32_t);
+    GLint maxDepth = 0;
+    GLCHECK(glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxDepth));
+    std::size_t nbGridsPerChunk = std::min(MAX_INSTANCED_BYTES / gridBytes, (std::size_t)maxDepth / slabsPerGrid);
+    nbGridsPerChunk = std::max(std::min(nbGridsPerChunk, transforms.size()), (std::size_t)1);
+
+    /* Saving current state for later restoration */
+    GLint previousFramebufferId;
+    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+
+    setupImagePass(shader, mode);
+    GLuint gridMatricesULoc = shader.getUniformLocation("gridMatrices");
+    if (gridMatricesULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(gridMatricesULoc, 0));
+    }
+    GLuint solidULoc = shader.getUniformLocation("solid");
+    if (solidULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(solidULoc, solid));
+    }
+    GLuint firstInstanceULoc = shader.getUniformLocation("firstInstance");
+
+    for (std::size_t first = 0 ; first < transforms.size() ; first += nbGridsPerChunk) {
+        const std::size_t nbGrids = std::min(nbGridsPerChunk, transforms.size() - first);
+
+        /* A single draw for all the grids of the chunk */
+        const GLuint gridsTextureId = acquireTexture(GL_R32UI, glm::uvec3(_nbVoxels.x, _nbVoxels.y, nbGrids * slabsPerGrid));
+        beginTimer(&Stats::imageDraw);
+        bindClearedImage(gridsTextureId);
+
+        ShaderProgram::bind(shader);
+        if (firstInstanceULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform1i(firstInstanceULoc, first));
+        }
+        mesh.drawInstanced(shader, nbGrids);
+        endTimer();
+
+        GLCHECK(glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT));
+        GLCHECK(glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI));
+
+        /* Each grid is read back from its own layers */
+        for (std::size_t iG = 0 ; iG < nbGrids ; ++iG) {
+            selectTransformedGrid(minCorners[first + iG]);
+            startReadback(gridsTextureId, 1, solid, iG * slabsPerGrid);
+            wait();
+            callback(first + iG, _voxels);
+        }
+        releaseTexture(gridsTextureId);
+    }
+
+    /* Restoring previous state */
+    GLCHECK(glBindTexture(GL_TEXTURE_BUFFER, 0));
+    ShaderProgram::unbind();
+
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+}
+
+bool Voxelizer::computeSparseVoxelsWithImage(MeshRenderable& mesh, Mode mode, std::vector<uint32_t> const& table,
+                                             std::size_t nbBricks, SparseGrid& sparse)
+{
+    if (_framebufferId == (GLuint)(-1)) {
+        std::cerr << "Voxels couldn't be computed: invalid framebuffer." << std::endl;
+        return true;
+    }
+    const bool conservative = (mode == Mode::Conservative6 || mode == Mode::Conservative26);
+    ShaderProgram& shader = conservative ? _conservativeImageShader : _flatImageShader;
+    if (!shader.isValid()) {
+        std::cerr << "Voxels couldn't be computed: invalid shader." << std::endl;
+        return true;
+    }
+    if (nbBricks == 0)
+        return true;
+
+    /* The pool stacks the bricks along Y, then along the depth: each brick is contiguous once read back */
+    const unsigned int n = SparseGrid::BRICK_SIZE;
+    const glm::uvec3 nbBricks3 = _nbVoxels / n;
+    GLint maxSize = 0;
+    GLCHECK(glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize));
+    const std::size_t bricksPerLayer = std::min((std::size_t)maxSize / n, nbBricks);
+    const std::size_t nbLayers = (nbBricks + bricksPerLayer - 1) / bricksPerLayer;
+    if (nbLayers > (std::size_t)maxSize || glm::compMax(nbBricks3) > (unsigned int)maxSize)
+        return false;
+
+    /* Saving current state for later restoration */
+    const glm::mat4 modelMatrix = mesh.modelMatrix();
+    GLint previousFramebufferId;
+    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+
+    const GLuint tableTextureId = acquireTexture(GL_R32UI, nbBricks3);
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, tableTextureId));
+    GLCHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    GLCHECK(glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, nbBricks3.x, nbBricks3.y, nbBricks3.z,
+                            GL_RED_INTEGER, GL_UNSIGNED_INT, table.data()));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+
+    setupImagePass(shader, mode);
+    GLuint sparseULoc = shader.getUniformLocation("sparse");
+    if (sparseULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(sparseULoc, true));
+    }
+    GLuint bricksPerLayerULoc = shader.getUniformLocation("bricksPerLayer");
+    if (bricksPerLayerULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1ui(bricksPerLayerULoc, bricksPerLayer));
+    }
+
+    const GLuint poolTextureId = acquireTexture(GL_R32UI, glm::uvec3(n, n * bricksPerLayer, nbLayers));
+    beginTimer(&Stats::imageDraw);
+    bindClearedImage(poolTextureId);
+    GLCHECK(glBindImageTexture(1, tableTextureId, 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI));
+
+    /* A single draw, see computeVoxelsWithImage. The fragments outside of the bricks of the table are dropped. */
+    mesh.modelMatrix() = glm::mat4(1.f);
+    mesh.draw(shader);
+    endTimer();
+
+    GLCHECK(glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT));
+    GLCHECK(glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI));
+    GLCHECK(glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI));
+    if (sparseULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(sparseULoc, false));
+    }
+
+    std::vector<uint32_t> pool(nbLayers * bricksPerLayer * SparseGrid::BRICK_WORDS);
+    beginTimer(&Stats::readback);
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, poolTextureId));
+    GLCHECK(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+    GLCHECK(glGetTexImage(GL_TEXTURE_3D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, pool.data()));
+    endTimer();
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    releaseTexture(poolTextureId);
+    releaseTexture(tableTextureId);
+
+    /* The bricks left empty are dropped, the others are kept in Z, Y, X order */
+    glm::uvec3 iB;
+    std::size_t iTable = 0;
+    for (iB.z = 0 ; iB.z < nbBricks3.z ; ++iB.z) {
+        for (iB.y = 0 ; iB.y < nbBricks3.y ; ++iB.y) {
+            for (iB.x = 0 ; iB.x < nbBricks3.x ; ++iB.x, ++iTable) {
+                if (table[iTable] == 0)
+                    continue;
+
+                auto from = pool.begin() + (std::size_t)(table[iTable] - 1) * SparseGrid::BRICK_WORDS;
+                if (std::all_of(from, from + SparseGrid::BRICK_WORDS, [](uint32_t word) { return word == 0u; }))
+                    continue;
+                std::copy(from, from + SparseGrid::BRICK_WORDS, sparse.addBrick(iB));
+            }
+        }
+    }
+
+    /* Restoring previous state */
+    ShaderProgram::unbind();
+
+    mesh.modelMatrix() = modelMatrix;
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+    return true;
+}
+
+void Voxelizer::drawSlice(MeshRenderable& mesh, ShaderProgram& shader, Axis axis, unsigned int slice, unsigned int nbLayers, bool includeBelow)
+{
+    glm::mat4 viewProj, rot;
+    const unsigned int axisIndex = (axis == Axis::X) ? 0 : ((axis == Axis::Y) ? 1 : 2);
+    const float near = _minCorner[axisIndex] + _voxelSize * (float)(slice);
+    const float far = near + (float)nbLayers * _voxelSize;
+
+    /* The projection axis goes to -Z (the depth grows along the axis), the two others to X and Y unmirrored,
+     * so that pixel (i,j) is the column (i,j) of the projection texture whatever the grid position */
+    if (axis == Axis::X) {
+        viewProj = glm::ortho(_minCorner.y, _maxCorner.y, //left right
+                              _minCorner.z, _maxCorner.z, //bottom top
+                              near, far); //near far
+
+        rot = glm::mat4(glm::vec4(0,0,-1,0), glm::vec4(1,0,0,0), glm::vec4(0,1,0,0), glm::vec4(0,0,0,1));
+    } else if (axis == Axis::Y) {
+        viewProj = glm::ortho(_minCorner.x, _maxCorner.x, //left right
+                              _minCorner.z, _maxCorner.z, //bottom top
+                              near, far); //near far
+
+        rot = glm::mat4(glm::vec4(1,0,0,0), glm::vec4(0,0,-1,0), glm::vec4(0,1,0,0), glm::vec4(0,0,0,1));
+    } else { //Z
+        viewProj = glm::ortho(_minCorner.x, _maxCorner.x, //left right
+                              _minCorner.y, _maxCorner.y, //bottom top
+                              near, far); //near far
+
+        rot = glm::mat4(glm::vec4(1,0,0,0), glm::vec4(0,1,0,0), glm::vec4(0,0,-1,0), glm::vec4(0,0,0,1));
+    }
+    mesh.modelMatrix() = rot * _meshTransform;
+
+    GLuint viewProjULoc = shader.getUniformLocation("viewProjMatrix");
+    if(viewProjULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniformMatrix4fv(viewProjULoc, 1, GL_FALSE, glm::value_ptr(viewProj)));
+    }
+
+    /* Margin of one voxel for the rounding errors */
+    const float lowest = includeBelow ? std::numeric_limits<float>::lowest() : near - _voxelSize;
+    if (_meshTransform == glm::mat4(1.f))
+        mesh.drawRange(shader, axisIndex, lowest, far + _voxelSize);
+    else
+        mesh.draw(shader); //the triangles are sorted in the untransformed coordinates
+}
+
+void Voxelizer::computeCoverage(MeshRenderable& mesh, Mode mode)
+{
+    const bool solid = (mode == Mode::Solid);
+    ShaderProgram& sliceShader = solid ? _solidSliceShader : _sliceShader;
+    if (!sliceShader.isValid() || !_coverageShader.isValid()) {
+        std::cerr << "Coverage couldn't be computed: invalid shader." << std::endl;
+        return;
+    }
+
+    GLint maxSamples = 1;
+    GLCHECK(glGetIntegerv(GL_MAX_INTEGER_SAMPLES, &maxSamples));
+    const GLsizei nbSamples = std::min((GLint)_nbCoverageSamples, maxSamples);
+
+    /* Saving current state for later restoration */
+    const glm::mat4 modelMatrix = mesh.modelMatrix();
+    GLint previousFramebufferId;
+    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId));
+    GLenum drawBuffers[1] = {GL_COLOR_ATTACHMENT0};
+    GLCHECK(glDrawBuffers(1, drawBuffers));
+    beginTimer(&Stats::coverage);
+
+    GLCHECK(glDisable(GL_DEPTH_TEST));
+    GLCHECK(glDisable(GL_BLEND));
+    GLCHECK(glDisable(GL_CULL_FACE));
+    GLCHECK(glEnable(GL_MULTISAMPLE));
+    GLCHECK(glEnable(GL_COLOR_LOGIC_OP));
+    GLCHECK(glLogicOp(solid ? GL_XOR : GL_OR));
+    GLCHECK(glClearColor(0.f, 0.f, 0.f, 0.f));
+
+    ShaderProgram::bind(sliceShader);
+    GLuint firstLayerULoc = sliceShader.getUniformLocation("firstLayer");
+    GLuint nbLayersULoc = sliceShader.getUniformLocation("nbLayers");
+    if (nbLayersULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1f(nbLayersULoc, _nbVoxels.z));
+    }
+    GLuint slabWidthULoc = sliceShader.getUniformLocation("slabWidth");
+    if (slabWidthULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1ui(slabWidthULoc, 32u));
+    }
+
+    /* Same projections as computeVoxels, in multisampled textures: (width, height, depth) for each axis.
+     * Multisampled textures can't be 3D, each 32 slices go in a layer of a 2D array (R32UI: the samples are already large). */
+    const Axis axes[3] = {Axis::X, Axis::Y, Axis::Z};
+    const glm::uvec3 sizes[3] = {glm::uvec3(_nbVoxels.y, _nbVoxels.z, _nbVoxels.x),
+                                 glm::uvec3(_nbVoxels.x, _nbVoxels.z, _nbVoxels.y),
+                                 glm::uvec3(_nbVoxels.x, _nbVoxels.y, _nbVoxels.z)};
+    GLuint projTextureIds[3] = {0, 0, 0};
+    GLCHECK(glGenTextures(3, projTextureIds));
+    for (unsigned int iA = solid ? 2 : 0 ; iA < 3 ; ++iA) {
+        glm::uvec3 const& size = sizes[iA];
+        GLCHECK(glBindTexture(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, projTextureIds[iA]));
+        GLCHECK(glTexImage3DMultisample(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, nbSamples, GL_R32UI, size.x, size.y, size.z/32, GL_TRUE));
+
+        GLCHECK(glViewport(0, 0, size.x, size.y));
+        for (unsigned int slice = 0 ; slice < size.z ; slice += 32) {
+            GLCHECK(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, projTextureIds[iA], 0, slice/32));
+            GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
+
+            if (solid) {
+                GLCHECK(glUniform1ui(firstLayerULoc, slice));
+                drawSlice(mesh, sliceShader, axes[iA], 0, size.z, true);
+            } else {
+                drawSlice(mesh, sliceShader, axes[iA], slice, 32);
+            }
+        }
+    }
+    GLCHECK(glBindTexture(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, 0));
+    GLCHECK(glDisable(GL_COLOR_LOGIC_OP));
+
+    /* Then counting the samples of each voxel, one Z-layer at a time */
+    const GLuint coverageTextureId = acquireTexture(GL_R8UI, _nbVoxels);
+
+    ShaderProgram::bind(_coverageShader);
+    const char* texNames[3] = {"xProjTex", "yProjTex", "zProjTex"};
+    for (unsigned int iA = 0 ; iA < 3 ; ++iA) {
+        GLuint texULoc = _coverageShader.getUniformLocation(texNames[iA]);
+        if (texULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform1i(texULoc, iA));
+        }
+        GLCHECK(glActiveTexture(GL_TEXTURE0 + iA));
+        GLCHECK(glBindTexture(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, projTextureIds[iA]));
+    }
+    GLuint nbSamplesULoc = _coverageShader.getUniformLocation("nbSamples");
+    if (nbSamplesULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(nbSamplesULoc, nbSamples));
+    }
+    GLuint solidULoc = _coverageShader.getUniformLocation("solid");
+    if (solidULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(solidULoc, solid));
+    }
+    GLuint maxValueULoc = _coverageShader.getUniformLocation("maxValue");
+    if (maxValueULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1f(maxValueULoc, (_coverage == Coverage::Bits4) ? 15.f : 255.f));
+    }
+    GLuint layerULoc = _coverageShader.getUniformLocation("layer");
+
+    GLCHECK(glBindVertexArray(emptyVAO()));
+    GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.y));
+    for (unsigned int iZ = 0 ; iZ < _nbVoxels.z ; ++iZ) {
+        GLCHECK(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, coverageTextureId, 0, iZ));
+        if (layerULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform1i(layerULoc, iZ));
+        }
+        GLCHECK(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    }
+    GLCHECK(glBindVertexArray(0));
+
+    /* The R8UI texture is already ordered by Z, Y, X */
+    std::vector<uint8_t> bytes((std::size_t)_nbVoxels.x * _nbVoxels.y * _nbVoxels.z);
+    GLCHECK(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, coverageTextureId));
+    GLCHECK(glGetTexImage(GL_TEXTURE_3D, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, bytes.data()));
+    GLCHECK(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+    if (_coverage == Coverage::Bits4) {
+        _coverageGrid.resize(bytes.size() / 2);
+        for (std::size_t i = 0 ; i < _coverageGrid.size() ; ++i)
+            _coverageGrid[i] = (uint8_t)(bytes[2*i] | (bytes[2*i + 1] << 4));
+    } else {
+        _coverageGrid.swap(bytes);
+    }
+    endTimer();
+
+    /* Restoring previous state */
+    for (unsigned int iA = 0 ; iA < 3 ; ++iA) {
+        GLCHECK(glActiveTexture(GL_TEXTURE0 + iA));
+        GLCHECK(glBindTexture(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, 0));
+    }
+    GLCHECK(glActiveTexture(GL_TEXTURE0));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
+    GLCHECK(glDeleteTextures(3, projTextureIds));
+    releaseTexture(coverageTextureId);
+
+    ShaderProgram::unbind();
+
+    mesh.modelMatrix() = modelMatrix;
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+}
+
+void Voxelizer::keepGridTexture(GLuint textureId, unsigned int nbChannels, bool sweep)
+{
+    if (!_gridTextureShader.isValid()) {
+        std::cerr << "Grid texture couldn't be computed: invalid shader." << std::endl;
+        return;
+    }
+    _gridTextureId = acquireTexture(GL_R32UI, glm::uvec3(_nbVoxels.x, _nbVoxels.y, _nbVoxels.z/32));
+
+    ShaderProgram::bind(_gridTextureShader);
+    GLuint nbChannelsULoc = _gridTextureShader.getUniformLocation("nbChannels");
+    if (nbChannelsULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1ui(nbChannelsULoc, nbChannels));
+    }
+    GLuint sweepULoc = _gridTextureShader.getUniformLocation("sweep");
+    if (sweepULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(sweepULoc, sweep));
+    }
+    GLuint sourceULoc = _gridTextureShader.getUniformLocation("source");
+    if (sourceULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(sourceULoc, 0));
+    }
+    GLuint sliceULoc = _gridTextureShader.getUniformLocation("slice");
+
+    /* Plain copy, whatever the voxelization did */
+    beginTimer(&Stats::compile);
+    GLCHECK(glDisable(GL_COLOR_LOGIC_OP));
+    GLCHECK(glActiveTexture(GL_TEXTURE0));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, textureId));
+    GLCHECK(glBindVertexArray(emptyVAO()));
+    GLCHECK(glViewport(0, 0, _nbVoxels.x, _nbVoxels.y));
+    for (unsigned int iS = 0 ; iS < _nbVoxels.z / 32 ; ++iS) {
+        GLCHECK(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _gridTextureId, 0, iS));
+        if (sliceULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform1ui(sliceULoc, iS));
+        }
+        GLCHECK(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    }
+    GLCHECK(glBindVertexArray(0));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
+    endTimer();
+
+    ShaderProgram::unbind();
+}
+
+void Voxelizer::releasePyramid()
+{
+    for (GLuint textureId : _pyramidTextureIds)
+        releaseTexture(textureId);
+    _pyramidTextureIds.clear();
+    _pyramidLevels.clear();
+    _pyramidSizes.clear();
+    _pyramidPending = false;
+}
+
+void Voxelizer::startPyramid()
+{
+    releasePyramid();
+    if (!_pyramid || _nbVoxels.x == 0)
+        return;
+
+    /* Down to a single voxel */
+    _pyramidSizes.push_back(_nbVoxels);
+    while (_pyramidSizes.back() != glm::uvec3(1u))
+        _pyramidSizes.push_back((_pyramidSizes.back() + 1u) / 2u);
+
+    if (_gridTextureId != (GLuint)(-1))
+        computePyramidTextures();
+
+    /* The levels in memory wait for the grid to be read back */
+    if (!_voxels.empty()) {
+        _pyramidPending = true;
+        if (_readbackFences.empty())
+            computePyramidLevels();
+    }
+}
+
+void Voxelizer::computePyramidLevels()
+{
+    _pyramidPending = false;
+    _pyramidLevels.resize(_pyramidSizes.size() - 1);
+    for (std::size_t iL = 1 ; iL < _pyramidSizes.size() ; ++iL) {
+        glm::uvec3 size;
+        CPUVoxelization::orReduce(_pyramidSizes[iL - 1], pyramidLevel(iL - 1), size, _pyramidLevels[iL - 1]);
+    }
+}
+
+void Voxelizer::computePyramidTextures()
+{
+    if (!_pyramidShader.isValid()) {
+        std::cerr << "Pyramid couldn't be computed: invalid shader." << std::endl;
+        return;
+    }
+
+    GLint previousFramebufferId;
+    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId));
+
+    ShaderProgram::bind(_pyramidShader);
+    GLuint finerULoc = _pyramidShader.getUniformLocation("finer");
+    if (finerULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(finerULoc, 0));
+    }
+    GLuint finerSizeULoc = _pyramidShader.getUniformLocation("finerSize");
+    GLuint sliceULoc = _pyramidShader.getUniformLocation("slice");
+
+    /* Each level is read from the previous one, slab by slab */
+    beginTimer(&Stats::pyramid);
+    GLCHECK(glDisable(GL_COLOR_LOGIC_OP));
+    GLCHECK(glActiveTexture(GL_TEXTURE0));
+    GLCHECK(glBindVertexArray(emptyVAO()));
+    for (std::size_t iL = 1 ; iL < _pyramidSizes.size() ; ++iL) {
+        glm::uvec3 const& finerSize = _pyramidSizes[iL - 1];
+        glm::uvec3 const& size = _pyramidSizes[iL];
+        const unsigned int nbSlabs = (size.z + 31) / 32;
+        const GLuint textureId = acquireTexture(GL_R32UI, glm::uvec3(size.x, size.y, nbSlabs));
+        _pyramidTextureIds.push_back(textureId);
+
+        GLCHECK(glBindTexture(GL_TEXTURE_3D, pyramidTexture(iL - 1)));
+        if (finerSizeULoc != ShaderProgram::nullLocation) {
+            GLCHECK(glUniform3ui(finerSizeULoc, finerSize.x, finerSize.y, (finerSize.z + 31) / 32));
+        }
+        GLCHECK(glViewport(0, 0, size.x, size.y));
+        for (unsigned int iS = 0 ; iS < nbSlabs ; ++iS) {
+            GLCHECK(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureId, 0, iS));
+            if (sliceULoc != ShaderProgram::nullLocation) {
+                GLCHECK(glUniform1ui(sliceULoc, iS));
+            }
+            GLCHECK(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+        }
+    }
+    GLCHECK(glBindVertexArray(0));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
+    endTimer();
+
+    ShaderProgram::unbind();
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+}
+
+void Voxelizer::startReadback(GLuint textureId, unsigned int nbChannels, bool sweep, unsigned int firstLayer)
+{
+    const unsigned int nbLayers = (_nbVoxels.z / 32 + nbChannels - 1) / nbChannels;
+    const std::size_t layerSize = (std::size_t)_nbVoxels.x * _nbVoxels.y * nbChannels * sizeof(uint32_t);
+    const std::size_t size = layerSize * nbLayers;
+
+    if (_readbackBufferId == (GLuint)(-1)) {
+        GLCHECK(glGenBuffers(1, &_readbackBufferId));
+    }
+    GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, _readbackBufferId));
+    if (size > _readbackBufferSize) {
+        GLCHECK(glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ));
+        _readbackBufferSize = size;
+    }
+
+    /* One layer at a time, so that the first slabs are available first */
+    GLCHECK(glReadBuffer(GL_COLOR_ATTACHMENT0));
+    GLCHECK(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+    beginTimer(&Stats::readback);
+    for (unsigned int iL = 0 ; iL < nbLayers ; ++iL) {
+        GLCHECK(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureId, 0, firstLayer + iL));
+        GLCHECK(glReadPixels(0, 0, _nbVoxels.x, _nbVoxels.y, pixelFormat(nbChannels), GL_UNSIGNED_INT, (void*)(iL * layerSize)));
+        _readbackFences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+    endTimer();
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
+    GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    GLCHECK(glFlush());
+
+    _nbReadySlabs = 0;
+    _readbackNbChannels = nbChannels;
+    _readbackSweep = sweep;
+    if (sweep)
+        _sweepCarries.assign((std::size_t)_nbVoxels.x * _nbVoxels.y, 0u);
+}
+
+unsigned int Voxelizer::updateReadback(GLuint64 timeout)
+{
+    /* Nothing pending: the CPU backend and the Texture output are final as soon as they return */
+    const unsigned int nbSlabs = _nbVoxels.z / 32;
+    if (_readbackFences.empty())
+        return nbSlabs;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const unsigned int nbChannels = _readbackNbChannels;
+    const std::size_t slabWords = (std::size_t)_nbVoxels.x * _nbVoxels.y;
+    GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, _readbackBufferId));
+    while (_nbReadySlabs < nbSlabs) {
+        const unsigned int iL = _nbReadySlabs / nbChannels;
+        GLsync fence = _readbackFences[iL];
+        const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        /* The channels of a layer are consecutive slabs, interleaved texel by texel */
+        const unsigned int nbLayerSlabs = std::min(nbChannels, nbSlabs - _nbReadySlabs);
+        void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, iL * slabWords * nbChannels * sizeof(uint32_t),
+                                      slabWords * nbChannels * sizeof(uint32_t), GL_MAP_READ_BIT);
+        if (data) {
+            uint32_t const* words = (uint32_t const*)data;
+            for (unsigned int iC = 0 ; iC < nbLayerSlabs ; ++iC) {
+                uint32_t* slab = _voxels.data() + (_nbReadySlabs + iC) * slabWords;
+                for (std::size_t i = 0 ; i < slabWords ; ++i)
+                    slab[i] = words[nbChannels * i + iC];
+            }
+            GLCHECK(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+        } else {
+            std::cerr << "Error: couldn't map the readback buffer." << std::endl;
+        }
+        for (unsigned int iC = 0 ; iC < nbLayerSlabs && _readbackSweep ; ++iC)
+            CPUVoxelization::prefixXorSweepSlab(_voxels.data() + (_nbReadySlabs + iC) * slabWords, _sweepCarries.data(), slabWords);
+
+        GLCHECK(glDeleteSync(fence));
+        _nbReadySlabs += nbLayerSlabs;
+    }
+    GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    if (_nbReadySlabs == nbSlabs) {
+        _readbackFences.clear();
+        if (_pyramidPending)
+            computePyramidLevels();
+
+        /* The timed passes came before the fences */
+        collectTimers();
+        _stats.cpuTotal = elapsedMs(_statsStart);
+    }
+    _stats.cpuReadback += elapsedMs(start);
+    return _nbReadySlabs;
+}
+
+unsigned int Voxelizer::nbReadySlabs()
+{
+    return updateReadback(0);
+}
+
+bool Voxelizer::isReady()
+{
+    return nbReadySlabs() == _nbVoxels.z / 32;
+}
+
+void Voxelizer::wait()
+{
+    updateReadback(GL_TIMEOUT_IGNORED);
+}
+
+Voxelizer::Stats const& Voxelizer::lastStats() const
+{
+    collectTimers();
+    return _stats;
+}
+
+void Voxelizer::resetStats()
+{
+    _pendingTimers.clear();
+    _stats = Stats();
+    _statsStart = std::chrono::steady_clock::now();
+}
+
+void Voxelizer::endSubmit()
+{
+    _stats.cpuSubmit = elapsedMs(_statsStart);
+    if (_readbackFences.empty())
+        _stats.cpuTotal = _stats.cpuSubmit;
+}
+
+void Voxelizer::discardFirstTimer()
+{
+    /* Once per context, the Voxelizers of a context (e.g. a VoxelizerBatch) sharing it */
+    static std::set<void*> discardedContexts;
+    const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    if (!renderer || !std::strstr(renderer, "llvmpipe") || !discardedContexts.insert(currentContext()).second)
+        return;
+
+    /* The query has to cover some rendering, an empty one is right anyway */
+    GLint previousFramebufferId;
+    GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebufferId));
+    GLuint textureId;
+    allocate3DTexture(textureId, GL_R32UI, 1, 1, 1);
+    const GLuint zero[4] = {0u, 0u, 0u, 0u};
+    GLuint queryId;
+    GLCHECK(glGenQueries(1, &queryId));
+
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId));
+    GLCHECK(glBeginQuery(GL_TIME_ELAPSED, queryId));
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureId, 0));
+    GLCHECK(glClearBufferuiv(GL_COLOR, 0, zero));
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
+    GLCHECK(glEndQuery(GL_TIME_ELAPSED));
+    GLuint64 nanoseconds = 0;
+    GLCHECK(glGetQueryObjectui64v(queryId, GL_QUERY_RESULT, &nanoseconds));
+
+    GLCHECK(glDeleteQueries(1, &queryId));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    GLCHECK(glDeleteTextures(1, &textureId));
+    GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, previousFramebufferId));
+}
+
+void Voxelizer::beginTimer(double Stats::* phase)
+{
+    if (_pendingTimers.size() == _timerQueryIds.size()) {
+        GLuint queryId;
+        GLCHECK(glGenQueries(1, &queryId));
+        _timerQueryIds.push_back(queryId);
+    }
+    GLCHECK(glBeginQuery(GL_TIME_ELAPSED, _timerQueryIds[_pendingTimers.size()]));
+    _pendingTimers.push_back(phase);
+}
+
+void Voxelizer::endTimer()
+{
+    GLCHECK(glEndQuery(GL_TIME_ELAPSED));
+}
+
+void Voxelizer::collectTimers() const
+{
+    for (std::size_t i = 0 ; i < _pendingTimers.size() ; ++i) {
+        GLuint64 nanoseconds = 0;
+        GLCHECK(glGetQueryObjectui64v(_timerQueryIds[i], GL_QUERY_RESULT, &nanoseconds));
+        _stats.*_pendingTimers[i] += nanoseconds / 1e6;
+    }
+    _pendingTimers.clear();
+}
+
+GLuint Voxelizer::acquireTexture(GLenum internalFormat, glm::uvec3 const& size)
+{
+    for (PooledTexture& texture : _texturePool) {
+        if (!texture.inUse && texture.internalFormat == internalFormat && texture.size == size) {
+            texture.inUse = true;
+            return texture.id;
+        }
+    }
+
+    PooledTexture texture = {0, internalFormat, size, true};
+    allocate3DTexture(texture.id, internalFormat, size.x, size.y, size.z);
+    _texturePool.push_back(texture);
+    return texture.id;
+}
+
+void Voxelizer::releaseTexture(GLuint textureId)
+{
+    for (std::size_t i = 0 ; i < _texturePool.size() ; ++i) {
+        if (_texturePool[i].id == textureId) {
+            PooledTexture texture = _texturePool[i];
+            texture.inUse = false;
+            _texturePool.erase(_texturePool.begin() + i);
+            _texturePool.push_back(texture);
+            break;
+        }
+    }
+
+    std::size_t nbIdle = 0;
+    for (PooledTexture const& texture : _texturePool)
+        nbIdle += texture.inUse ? 0 : 1;
+    for (std::size_t i = 0 ; i < _texturePool.size() && nbIdle > MAX_IDLE_TEXTURES ; ) {
+        if (!_texturePool[i].inUse) {
+            GLCHECK(glDeleteTextures(1, &_texturePool[i].id));
+            _texturePool.erase(_texturePool.begin() + i);
+            --nbIdle;
+        } else {
+            ++i;
+        }
+    }
+}
+
+GLuint Voxelizer::emptyVAO()
+{
+    if (_emptyVaoId == (GLuint)(-1)) {
+        GLCHECK(glGenVertexArrays(1, &_emptyVaoId));
+    }
+    return _emptyVaoId;
+}
+
+void Voxelizer::trim()
+{
+    collectTimers();
+    if (!_timerQueryIds.empty()) {
+        GLCHECK(glDeleteQueries(_timerQueryIds.size(), _timerQueryIds.data()));
+        _timerQueryIds.clear();
+    }
+
+    for (std::size_t i = 0 ; i < _texturePool.size() ; ) {
+        if (!_texturePool[i].inUse) {
+            GLCHECK(glDeleteTextures(1, &_texturePool[i].id));
+            _texturePool.erase(_texturePool.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+
+    if (_emptyVaoId != (GLuint)(-1)) {
+        GLCHECK(glDeleteVertexArrays(1, &_emptyVaoId));
+        _emptyVaoId = -1;
+    }
+    if (_gridMatricesBufferId != (GLuint)(-1)) {
+        GLCHECK(glDeleteTextures(1, &_gridMatricesTextureId));
+        GLCHECK(glDeleteBuffers(1, &_gridMatricesBufferId));
+        _gridMatricesTextureId = -1;
+        _gridMatricesBufferId = -1;
+    }
+    if (_readbackBufferId != (GLuint)(-1) && _readbackFences.empty()) {
+        GLCHECK(glDeleteBuffers(1, &_readbackBufferId));
+        _readbackBufferId = -1;
+        _readbackBufferSize = 0;
+    }
+}
+
+void Voxelizer::drawLayers(MeshRenderable& mesh, Axis axis, GLuint textureId, unsigned int width, unsigned int height,
+                           unsigned int nbLayers, unsigned int slabWidth)
+{
+    GLCHECK(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureId, 0));
+    GLCHECK(glViewport(0, 0, width, height));
+    GLCHECK(glClear(GL_COLOR_BUFFER_BIT));
+
+    /* The last slab may go beyond the grid */
+    const unsigned int nbSlabs = (nbLayers + slabWidth - 1) / slabWidth;
+    GLuint nbSlabsULoc = _layeredSliceShader.getUniformLocation("nbSlabs");
+    if (nbSlabsULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(nbSlabsULoc, nbSlabs));
+    }
+
+    drawSlice(mesh, _layeredSliceShader, axis, 0, nbSlabs * slabWidth);
+}
+
+glm::uvec3 const& Voxelizer::getNbVoxels() const
+{
+    return _nbVoxels;
+}
+
+glm::vec3 const& Voxelizer::getMinCorner() const
+{
+    return _minCorner;
+}
+
+float Voxelizer::getVoxelSize() const
+{
+    return _voxelSize;
+}
+
+glm::vec3 Voxelizer::voxelPosition(unsigned int iX, unsigned int iY, unsigned int iZ) const
+{
+    return _minCorner + _voxelSize * glm::vec3(iX,iY,iZ) + .5f * glm::vec3(_voxelSize);
+}
+
+std::vector<Voxelizer::Box> const& Voxelizer::updatedBoxes() const
+{
+    return _updatedBoxes;
 }
 
 std::vector<uint32_t> const& Voxelizer::grid() const
@@ -0,0 +1,88 @@
+#include "VoxelizerBatch.hpp"
+
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+
+double VoxelizerBatch::Stats::meshesPerSecond() const
+{
+    return (seconds > 0.0) ? (double)nbMeshes / seconds : 0.0;
+}
+
+double VoxelizerBatch::Stats::voxelsPerSecond() const
+{
+    return (seconds > 0.0) ? (double)nbVoxels / seconds : 0.0;
+}
+
+VoxelizerBatch::VoxelizerBatch(unsigned int nbInFlight, Voxelizer::Backend backend, Voxelizer::GPUMethod gpuMethod)
+{
+    nbInFlight = std::max(1u, nbInFlight);
+    for (unsigned int i = 0 ; i < nbInFlight ; ++i)
+        _voxelizers.emplace_back(new Voxelizer(backend, gpuMethod));
+}
+
+unsigned int VoxelizerBatch::nbInFlight() const
+{
+    return _voxelizers.size();
+}
+
+Voxelizer& VoxelizerBatch::voxelizer(unsigned int i)
+{
+    return *_voxelizers[i];
+}
+
+VoxelizerBatch::Stats VoxelizerBatch::run(std::vector<Job> const& jobs, ResultCallback const& callback)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Stats stats = {0, 0, 0.0};
+    const Clock::time_point start = Clock::now();
+
+    /* Submitted jobs, oldest first, with the index of their Voxelizer */
+    struct Pending
+    {
+        std::size_t iJob;
+        unsigned int iVoxelizer;
+    };
+    std::deque<Pending> pending;
+    std::vector<unsigned int> idle;
+    for (unsigned int i = _voxelizers.size() ; i > 0 ; --i)
+        idle.push_back(i - 1);
+
+    auto deliverOldest = [&]() {
+        const Pending done = pending.front();
+        pending.pop_front();
+
+        Voxelizer& voxelizer = *_voxelizers[done.iVoxelizer];
+        voxelizer.wait();
+        const glm::uvec3 nbVoxels = voxelizer.getNbVoxels();
+        stats.nbMeshes += 1;
+        stats.nbVoxels += (std::size_t)nbVoxels.x * nbVoxels.y * nbVoxels.z;
+        if (callback)
+            callback(done.iJob, voxelizer);
+
+        idle.push_back(done.iVoxelizer);
+    };
+
+    for (std::size_t iJob = 0 ; iJob < jobs.size() ; ++iJob) {
+        if (idle.empty())
+            deliverOldest();
+
+        const unsigned int iVoxelizer = idle.back();
+        idle.pop_back();
+        Job const& job = jobs[iJob];
+        _voxelizers[iVoxelizer]->recomputeAsync(*job.mesh, job.resolution, job.mode);
+        pending.push_back(Pending{iJob, iVoxelizer});
+
+        /* Results already there don't wait for a Voxelizer to be needed */
+        while (!pending.empty() && _voxelizers[pending.front().iVoxelizer]->isReady())
+            deliverOldest();
+    }
+    while (!pending.empty())
+        deliverOldest();
+
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
@@ -1,6 +1,8 @@
 #include "VoxelsRenderable.hpp"
 
 
+#include <iostream>
+
 #include "GLHelper.hpp"
 
 
@@ -20,24 +22,12 @@ VoxelsRenderable::VoxelsRenderable(Voxelizer const& voxelizer):
 
     addCube(voxelizer.getVoxelSize(), glm::vec3(0.f), vertices, normals, indices);
 
-    /* Then parse the raw grid data to know where to instanciate the cubes */
-    std::vector<glm::vec3> positions;
-    glm::uvec3 nbVoxels = voxelizer.getNbVoxels();
-    std::vector<uint32_t>::const_iterator it = voxelizer.grid().begin();
-    for (unsigned int iZ = 0 ; iZ < nbVoxels.z ; iZ+=32) {
-        for (unsigned int iY = 0 ; iY < nbVoxels.y ; ++iY) {
-            for (unsigned int iX = 0 ; iX < nbVoxels.x ; ++iX) {
-                uint32_t v = *it;
-                if (v) {
-                    for (uint32_t i = 0 ; i < 32 ; ++i)
-                        if (v & (0b1 << i))
-                            positions.push_back(voxelizer.voxelPosition(iX,iY,iZ+i));
-                }
-                ++it;
-            }
-        }
-    }
-    _nbCubes = positions.size();
+    /* Then find where to instanciate the cubes */
+    GLCHECK(glGenBuffers(1, &_positionsBufferId));
+    if (voxelizer.gridTexture() != (GLuint)(-1))
+        positionsFromTexture(voxelizer);
+    else
+        positionsFromGrid(voxelizer);
 
     /* Buffers creation */
     GLCHECK(glGenBuffers(1, &_verticesBufferId));
@@ -52,10 +42,6 @@ VoxelsRenderable::VoxelsRenderable(Voxelizer const& voxelizer):
     GLCHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indicesBufferId));
     GLCHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(glm::ivec3), indices.data(), GL_STATIC_DRAW));
 
-    GLCHECK(glGenBuffers(1, &_positionsBufferId));
-    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, _positionsBufferId));
-    GLCHECK(glBufferData(GL_ARRAY_BUFFER, positions.size()*sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW));
-
     /*  VAO creation and binding */
     {
         const GLint vertALoc = 0;
@@ -113,6 +99,96 @@ unsigned int VoxelsRenderable::nbVoxels() const
     return _nbCubes;
 }
 
+void VoxelsRenderable::positionsFromGrid(Voxelizer const& voxelizer)
+{
+    /* Parse the raw grid data */
+    std::vector<glm::vec3> positions;
+    glm::uvec3 nbVoxels = voxelizer.getNbVoxels();
+    std::vector<uint32_t>::const_iterator it = voxelizer.grid().begin();
+    for (unsigned int iZ = 0 ; iZ < nbVoxels.z && it != voxelizer.grid().end() ; iZ+=32) {
+        for (unsigned int iY = 0 ; iY < nbVoxels.y ; ++iY) {
+            for (unsigned int iX = 0 ; iX < nbVoxels.x ; ++iX) {
+                uint32_t v = *it;
+                if (v) {
+                    for (uint32_t i = 0 ; i < 32 ; ++i)
+                        if (v & (0b1 << i))
+                            positions.push_back(voxelizer.voxelPosition(iX,iY,iZ+i));
+                }
+                ++it;
+            }
+        }
+    }
+    _nbCubes = positions.size();
+
+    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, _positionsBufferId));
+    GLCHECK(glBufferData(GL_ARRAY_BUFFER, positions.size()*sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW));
+}
+
+void VoxelsRenderable::positionsFromTexture(Voxelizer const& voxelizer)
+{
+    ShaderProgram compaction;
+    compaction.setTransformFeedbackVaryings({"cubePosition"});
+    if (!compaction.loadFromFile("shaders/voxelsCompaction.vert", "shaders/voxelsCompaction.geom", "")) {
+        std::cerr << "Error: couldn't load voxelsCompaction shader." << std::endl;
+        return;
+    }
+
+    const glm::uvec3 nbVoxels = voxelizer.getNbVoxels();
+    const GLsizei nbWords = nbVoxels.x * nbVoxels.y * (nbVoxels.z / 32);
+
+    ShaderProgram::bind(compaction);
+    GLuint gridULoc = compaction.getUniformLocation("grid");
+    if (gridULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1i(gridULoc, 0));
+    }
+    GLuint gridSizeULoc = compaction.getUniformLocation("gridSize");
+    if (gridSizeULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform3i(gridSizeULoc, nbVoxels.x, nbVoxels.y, nbVoxels.z / 32));
+    }
+    GLuint minCornerULoc = compaction.getUniformLocation("minCorner");
+    if (minCornerULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform3fv(minCornerULoc, 1, glm::value_ptr(voxelizer.getMinCorner())));
+    }
+    GLuint voxelSizeULoc = compaction.getUniformLocation("voxelSize");
+    if (voxelSizeULoc != ShaderProgram::nullLocation) {
+        GLCHECK(glUniform1f(voxelSizeULoc, voxelizer.getVoxelSize()));
+    }
+
+    GLuint vaoId, queryId;
+    GLCHECK(glGenVertexArrays(1, &vaoId));
+    GLCHECK(glGenQueries(1, &queryId));
+    GLCHECK(glBindVertexArray(vaoId));
+    GLCHECK(glActiveTexture(GL_TEXTURE0));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, voxelizer.gridTexture()));
+    GLCHECK(glEnable(GL_RASTERIZER_DISCARD));
+
+    /* First count the voxels, to size the buffer (only this number comes back to the CPU) */
+    GLCHECK(glBeginQuery(GL_PRIMITIVES_GENERATED, queryId));
+    GLCHECK(glDrawArrays(GL_POINTS, 0, nbWords));
+    GLCHECK(glEndQuery(GL_PRIMITIVES_GENERATED));
+    GLuint nbCubes = 0;
+    GLCHECK(glGetQueryObjectuiv(queryId, GL_QUERY_RESULT, &nbCubes));
+    _nbCubes = nbCubes;
+
+    /* Then capture their positions */
+    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, _positionsBufferId));
+    GLCHECK(glBufferData(GL_ARRAY_BUFFER, _nbCubes*sizeof(glm::vec3), nullptr, GL_STATIC_DRAW));
+    if (_nbCubes > 0) {
+        GLCHECK(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _positionsBufferId));
+        GLCHECK(glBeginTransformFeedback(GL_POINTS));
+        GLCHECK(glDrawArrays(GL_POINTS, 0, nbWords));
+        GLCHECK(glEndTransformFeedback());
+        GLCHECK(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0));
+    }
+
+    GLCHECK(glDisable(GL_RASTERIZER_DISCARD));
+    GLCHECK(glBindTexture(GL_TEXTURE_3D, 0));
+    GLCHECK(glBindVertexArray(0));
+    GLCHECK(glDeleteQueries(1, &queryId));
+    GLCHECK(glDeleteVertexArrays(1, &vaoId));
+    ShaderProgram::unbind();
+}
+
 void VoxelsRenderable::addCube(float cubeSize, glm::vec3 center,
                                std::vector<glm::vec3>& vertices,
                                std::vector<glm::vec3>& normals,
@@ -0,0 +1,226 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <sys/resource.h>
+
+#include "HeadlessContext.hpp"
+#include "MeshRenderable.hpp"
+#include "ToolHelpers.hpp"
+#include "Voxelizer.hpp"
+
+
+/* End-to-end benchmark of Voxelizer::recompute, meant to be diffed between commits (see "make bench").
+ * Each mesh, an .obj file or a generated one (see MeshGenerator::generate), is voxelized at each resolution:
+ * a few warmup runs, then the measured ones, giving the median and p95 latencies (nearest rank) and the peak resident memory.
+ * The JSON report has one line per run, always in the same order, and the number of set voxels tells whether the grid changed.
+ * A GPU grid with a side above GL_MAX_3D_TEXTURE_SIZE is computed with recomputeTiled instead, its line has the tile size.
+ * A run that doesn't produce the whole grid gets an "error" instead of its numbers, and the exit code is then a failure.
+ * Under Mesa, LIBGL_ALWAYS_SOFTWARE=1 selects llvmpipe so that the numbers don't depend on the GPU. */
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point const& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* Linux: the peak resident size is reset to the current one (since Linux 4.0), other systems keep the peak of the process */
+static void resetPeakMemory()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs)
+        clearRefs << "5";
+}
+
+/* In bytes */
+static std::size_t peakMemory()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::stoul(line.substr(6)) * 1024; //in kB
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (std::size_t)usage.ru_maxrss * 1024;
+}
+
+/* Nearest rank, on sorted times */
+static double percentile(std::vector<double> const& times, double p)
+{
+    const std::size_t rank = (std::size_t)std::ceil(p * times.size());
+    return times[std::max(rank, (std::size_t)1) - 1];
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage: bench [--backend gpu|cpu] [--gpu-method auto|projections|layered|image|dominant] [--mode surface|conservative6|conservative26|solid] [--resolutions 64,128,...] [--repetitions <n>] [--warmup <n>] [<obj file or sphere:<subdivisions>|soup:<triangles>|plates:<plates>> ...]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    /* Argument parsing */
+    Voxelizer::Backend backend = Voxelizer::Backend::GPU;
+    Voxelizer::GPUMethod gpuMethod = Voxelizer::GPUMethod::Auto;
+    Voxelizer::Mode mode = Voxelizer::Mode::Surface;
+    std::string modeName = "surface";
+    std::vector<unsigned int> resolutions = {64, 128, 256, 512, 1024};
+    unsigned int nbRepetitions = 10;
+    unsigned int nbWarmups = 2;
+    std::vector<std::string> meshes;
+    for (int i = 1 ; i < argc ; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--backend" && i + 1 < argc) {
+            if (!ToolHelpers::parseBackend(argv[++i], backend)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--gpu-method" && i + 1 < argc) {
+            if (!ToolHelpers::parseGPUMethod(argv[++i], gpuMethod)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--mode" && i + 1 < argc) {
+            modeName = argv[++i];
+            if (!ToolHelpers::parseMode(modeName, mode)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--resolutions" && i + 1 < argc) {
+            resolutions.clear();
+            if (!ToolHelpers::parseResolutions(argv[++i], resolutions)) {
+                std::cerr << "Error: invalid resolution list \"" << argv[i] << "\"." << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if ((arg == "--repetitions" || arg == "--warmup") && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            int value = -1;
+            if (!(ss >> value) || value < (arg == "--warmup" ? 0 : 1)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+            (arg == "--warmup" ? nbWarmups : nbRepetitions) = value;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            printUsage();
+            return EXIT_FAILURE;
+        } else {
+            meshes.push_back(arg);
+        }
+    }
+    if (meshes.empty())
+        meshes = {"rc/monkey.obj", "rc/human.obj", "sphere:5", "sphere:8", "soup:1000000", "plates:64"};
+
+    /* The CPU backend doesn't need any OpenGL context */
+    std::unique_ptr<HeadlessContext> context;
+    if (backend == Voxelizer::Backend::GPU) {
+        context.reset(new HeadlessContext());
+        if (!context->isValid())
+            return EXIT_FAILURE;
+        std::cerr << "Using OpenGL: " << context->description() << std::endl;
+    }
+    Voxelizer voxelizer(backend, gpuMethod);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\n";
+    std::cout << "  \"backend\": \"" << (backend == Voxelizer::Backend::GPU ? "gpu" : "cpu") << "\",\n";
+    if (backend == Voxelizer::Backend::GPU)
+        std::cout << "  \"gpuMethod\": \"" << ToolHelpers::gpuMethodName(voxelizer.gpuMethod()) << "\",\n";
+    std::cout << "  \"mode\": \"" << modeName << "\",\n";
+    std::cout << "  \"renderer\": \"" << (context ? context->description() : std::string("cpu")) << "\",\n";
+    std::cout << "  \"repetitions\": " << nbRepetitions << ",\n";
+    std::cout << "  \"warmup\": " << nbWarmups << ",\n";
+    std::cout << "  \"runs\": [";
+
+    /* Tiles of at most 512 voxels per side, below the GPU limit */
+    unsigned int maxTextureSize = 0;
+    if (backend == Voxelizer::Backend::GPU) {
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+        maxTextureSize = maxSize;
+    }
+    const unsigned int tileSize = std::max(32u, std::min(512u, maxTextureSize / 32 * 32));
+
+    bool firstRun = true;
+    bool failed = false;
+    for (std::string const& name : meshes) {
+        std::vector<glm::vec3> vertices, normals;
+        std::vector<glm::ivec3> triangles;
+        if (!ToolHelpers::loadMesh(name, vertices, normals, triangles))
+            return EXIT_FAILURE;
+
+        /* The upload isn't measured */
+        std::unique_ptr<MeshRenderable> mesh;
+        if (backend == Voxelizer::Backend::GPU)
+            mesh.reset(new MeshRenderable(vertices, normals, triangles));
+
+        for (unsigned int resolution : resolutions) {
+            std::cerr << name << " at " << resolution << "..." << std::endl;
+            resetPeakMemory();
+
+            const glm::uvec3 nbVoxels = Voxelizer::gridSize(vertices, resolution);
+            const std::size_t nbWords = (std::size_t)nbVoxels.x * nbVoxels.y * nbVoxels.z / 32;
+            const bool tiled = mesh && glm::any(glm::greaterThan(nbVoxels, glm::uvec3(maxTextureSize)));
+
+            /* The tiles are counted as they come, the voxels of the last run are reported */
+            std::size_t nbTileWords = 0;
+            std::size_t nbSetVoxels = 0;
+            const Voxelizer::TileCallback countTile = [&](glm::uvec3 const&, glm::uvec3 const&,
+                                                          std::vector<uint32_t> const& tile) {
+                nbTileWords += tile.size();
+                nbSetVoxels += ToolHelpers::countVoxels(tile);
+            };
+
+            std::vector<double> times;
+            bool complete = true;
+            for (unsigned int iRun = 0 ; iRun < nbWarmups + nbRepetitions ; ++iRun) {
+                nbTileWords = 0;
+                nbSetVoxels = 0;
+                const Clock::time_point start = Clock::now();
+                if (tiled)
+                    voxelizer.recomputeTiled(*mesh, resolution, tileSize, countTile, mode);
+                else if (mesh)
+                    voxelizer.recompute(*mesh, resolution, mode);
+                else
+                    voxelizer.recompute(vertices, triangles, resolution, mode);
+                if (tiled)
+                    complete = (nbTileWords == nbWords) && complete;
+                else
+                    complete = (voxelizer.grid().size() == nbWords) && complete;
+                if (iRun >= nbWarmups)
+                    times.push_back(elapsedMs(start));
+            }
+            std::sort(times.begin(), times.end());
+            if (!tiled)
+                nbSetVoxels = ToolHelpers::countVoxels(voxelizer.grid());
+
+            std::cout << (firstRun ? "\n" : ",\n");
+            firstRun = false;
+            std::cout << "    {\"mesh\": \"" << name << "\", \"triangles\": " << triangles.size()
+                      << ", \"resolution\": " << resolution
+                      << ", \"grid\": [" << nbVoxels.x << ", " << nbVoxels.y << ", " << nbVoxels.z << "]";
+            if (tiled)
+                std::cout << ", \"tile\": " << tileSize;
+            if (!complete) {
+                std::cerr << "Error: " << name << " at " << resolution << " didn't produce the whole grid." << std::endl;
+                std::cout << ", \"error\": \"incomplete grid\"}";
+                failed = true;
+                continue;
+            }
+            std::cout << ", \"voxels\": " << nbSetVoxels
+                      << ", \"median\": " << percentile(times, 0.5) << ", \"p95\": " << percentile(times, 0.95)
+                      << ", \"min\": " << times.front() << ", \"peakMemory\": " << peakMemory() << "}";
+        }
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "CPUVoxelization.hpp"
+#include "Voxelizer.hpp"
+#include "IO.hpp"
+
+
+/* Microbenchmark of the CPU column kernels (scalar, SSE4.2, AVX2, AVX-512).
+ * Runs single-threaded so only the kernel speed is measured,
+ * and checks that every variant gives the same grid as the scalar one. */
+
+typedef std::chrono::steady_clock Clock;
+
+static const unsigned int NB_REPETITIONS = 5;
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> meshes;
+    for (int i = 1 ; i < argc ; ++i)
+        meshes.push_back(argv[i]);
+    if (meshes.empty())
+        meshes = {"rc/monkey.obj", "rc/human.obj"};
+
+    const unsigned int resolutions[] = {64, 128, 256};
+    const CPUVoxelization::ISA isas[] = {CPUVoxelization::ISA::Scalar, CPUVoxelization::ISA::SSE42,
+                                         CPUVoxelization::ISA::AVX2, CPUVoxelization::ISA::AVX512};
+
+    bool identical = true;
+    bool firstRun = true;
+    std::cout << "{\n  \"detected\": \"" << CPUVoxelization::isaName(CPUVoxelization::detectISA()) << "\",\n";
+    std::cout << "  \"runs\": [";
+
+    for (std::string const& filename : meshes) {
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::ivec3> triangles;
+        if (!IO::readObj(filename, vertices, triangles))
+            return EXIT_FAILURE;
+
+        for (unsigned int resolution : resolutions) {
+            /* Grid dimensions as computed by the Voxelizer */
+            Voxelizer voxelizer(Voxelizer::Backend::CPU);
+            voxelizer.recompute(vertices, triangles, resolution);
+            const glm::uvec3 nbVoxels = voxelizer.getNbVoxels();
+
+            std::vector<uint32_t> reference;
+            double scalarTime = 0.0;
+            for (CPUVoxelization::ISA isa : isas) {
+                if (!CPUVoxelization::isSupported(isa))
+                    continue;
+
+                std::vector<uint32_t> grid;
+                std::vector<double> times;
+                for (unsigned int iRep = 0 ; iRep < NB_REPETITIONS ; ++iRep) {
+                    grid.assign(voxelizer.grid().size(), 0u);
+
+                    Clock::time_point start = Clock::now();
+                    CPUVoxelization::voxelize(vertices, triangles, voxelizer.getMinCorner(), voxelizer.getVoxelSize(),
+                                              nbVoxels, glm::uvec3(0u), grid, CPUVoxelization::Separability::Six, 1, isa);
+                    times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+                }
+                std::sort(times.begin(), times.end());
+                const double median = times[times.size() / 2];
+
+                if (isa == CPUVoxelization::ISA::Scalar) {
+                    reference = grid;
+                    scalarTime = median;
+                }
+                const bool same = (grid == reference);
+                identical = identical && same;
+
+                std::cout << (firstRun ? "\n" : ",\n");
+                firstRun = false;
+                std::cout << "    {\"mesh\": \"" << filename << "\", \"resolution\": " << resolution
+                          << ", \"isa\": \"" << CPUVoxelization::isaName(isa) << "\""
+                          << ", \"median\": " << median << ", \"min\": " << times.front()
+                          << ", \"speedup\": " << scalarTime / median
+                          << ", \"identical\": " << (same ? "true" : "false") << "}";
+            }
+        }
+    }
+
+    std::cout << "\n  ]\n}" << std::endl;
+
+    return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
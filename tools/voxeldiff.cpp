@@ -0,0 +1,279 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <bitset>
+#include <memory>
+#include <algorithm>
+
+#include "HeadlessContext.hpp"
+#include "MeshRenderable.hpp"
+#include "SparseGrid.hpp"
+#include "ToolHelpers.hpp"
+#include "Voxelizer.hpp"
+
+
+/* Differential check of two voxelization configurations (see "make check"): each mesh, an .obj file or a generated one
+ * (see MeshGenerator::generate), is voxelized by both at each resolution and the grids are compared word by word.
+ * A configuration is "<gpu|cpu>" followed by ":"-separated options: a GPU method (auto, projections, layered, image, dominant),
+ * "slab32", "slab64" or "slab128", "tile<size>" for recomputeTiled and "sparse" for recomputeSparse, the grid being rebuilt whole.
+ * The JSON report gives, for each comparison, the voxels only set by the second configuration (added) and only by the first
+ * (removed), with their bounding boxes. It fails when the Hamming distance (added + removed) is above the tolerance,
+ * a fraction of the voxels set by the first configuration. With --superset only the removed voxels count: the second
+ * grid must contain the first one, e.g. a GPU conservative grid compared with the exact CPU one. */
+
+struct Config
+{
+    std::string name;
+    Voxelizer::Backend backend;
+    Voxelizer::GPUMethod gpuMethod;
+    unsigned int slabWidth;
+    unsigned int tileSize; //0: whole grid
+    bool sparse;
+};
+
+/* Voxels set in one grid only, with their bounding box */
+struct Difference
+{
+    std::size_t nbVoxels;
+    glm::uvec3 minVoxel;
+    glm::uvec3 maxVoxel;
+};
+
+static bool parseConfig(std::string const& name, Config& config)
+{
+    config.name = name;
+    config.gpuMethod = Voxelizer::GPUMethod::Auto;
+    config.slabWidth = 0; //automatic
+    config.tileSize = 0;
+    config.sparse = false;
+
+    std::stringstream ss(name);
+    std::string item;
+    std::getline(ss, item, ':');
+    if (!ToolHelpers::parseBackend(item, config.backend))
+        return false;
+
+    while (std::getline(ss, item, ':')) {
+        if (item == "slab32" || item == "slab64" || item == "slab128") {
+            config.slabWidth = std::stoi(item.substr(4));
+        } else if (item == "sparse") {
+            config.sparse = true;
+        } else if (item.compare(0, 4, "tile") == 0) {
+            std::stringstream sizeStream(item.substr(4));
+            int size = 0;
+            if (!(sizeStream >> size) || size < 32 || size % 32 != 0)
+                return false;
+            config.tileSize = size;
+        } else if (!ToolHelpers::parseGPUMethod(item, config.gpuMethod)) {
+            return false;
+        }
+    }
+    return !(config.sparse && config.tileSize > 0);
+}
+
+/* The whole grid, whatever the way it was computed */
+static void computeGrid(Config const& config, Voxelizer& voxelizer, MeshRenderable* mesh,
+                        std::vector<glm::vec3> const& vertices, std::vector<glm::ivec3> const& triangles,
+                        unsigned int resolution, Voxelizer::Mode mode, std::vector<uint32_t>& grid)
+{
+    if (config.tileSize > 0) {
+        Voxelizer::TileCallback copyTile = [&](glm::uvec3 const& tileOrigin, glm::uvec3 const& tileSize,
+                                               std::vector<uint32_t> const& tile) {
+            const glm::uvec3 nbVoxels = voxelizer.getNbVoxels();
+            if (tileOrigin == glm::uvec3(0u))
+                grid.assign((std::size_t)nbVoxels.x * nbVoxels.y * nbVoxels.z / 32, 0u);
+            for (unsigned int iS = 0 ; iS < tileSize.z / 32 ; ++iS) {
+                for (unsigned int iY = 0 ; iY < tileSize.y ; ++iY) {
+                    auto from = tile.begin() + ((std::size_t)iS * tileSize.y + iY) * tileSize.x;
+                    const std::size_t to = ((std::size_t)(tileOrigin.z / 32 + iS) * nbVoxels.y + tileOrigin.y + iY) * nbVoxels.x + tileOrigin.x;
+                    std::copy(from, from + tileSize.x, grid.begin() + to);
+                }
+            }
+        };
+        if (mesh)
+            voxelizer.recomputeTiled(*mesh, resolution, config.tileSize, copyTile, mode);
+        else
+            voxelizer.recomputeTiled(vertices, triangles, resolution, config.tileSize, copyTile, mode);
+    } else if (config.sparse) {
+        SparseGrid sparse;
+        if (mesh)
+            voxelizer.recomputeSparse(*mesh, resolution, sparse, mode);
+        else
+            voxelizer.recomputeSparse(vertices, triangles, resolution, sparse, mode);
+        grid = sparse.toGrid();
+    } else {
+        if (mesh)
+            voxelizer.recompute(*mesh, resolution, mode);
+        else
+            voxelizer.recompute(vertices, triangles, resolution, mode);
+        grid = voxelizer.grid();
+    }
+}
+
+/* Adds the set bits of the word at index iWord of the grid */
+static void addWord(Difference& difference, uint32_t word, std::size_t iWord, glm::uvec3 const& nbVoxels)
+{
+    if (word == 0u)
+        return;
+
+    const unsigned int iX = iWord % nbVoxels.x;
+    const unsigned int iY = (iWord / nbVoxels.x) % nbVoxels.y;
+    const unsigned int firstZ = 32 * (iWord / ((std::size_t)nbVoxels.x * nbVoxels.y));
+    unsigned int lowest = 0, highest = 31;
+    while (!((word >> lowest) & 1u))
+        ++lowest;
+    while (!((word >> highest) & 1u))
+        --highest;
+
+    difference.minVoxel = glm::min(difference.minVoxel, glm::uvec3(iX, iY, firstZ + lowest));
+    difference.maxVoxel = glm::max(difference.maxVoxel, glm::uvec3(iX, iY, firstZ + highest));
+    difference.nbVoxels += std::bitset<32>(word).count();
+}
+
+static std::string boxJson(Difference const& difference)
+{
+    if (difference.nbVoxels == 0)
+        return "null";
+
+    std::stringstream json;
+    json << "[" << difference.minVoxel.x << ", " << difference.minVoxel.y << ", " << difference.minVoxel.z << ", "
+         << difference.maxVoxel.x << ", " << difference.maxVoxel.y << ", " << difference.maxVoxel.z << "]";
+    return json.str();
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage: voxeldiff [--mode surface|conservative6|conservative26|solid] [--resolutions 64,128,...] [--tolerance <fraction>] [--superset] <config A> <config B> [<obj file or sphere:<subdivisions>|soup:<triangles>|plates:<plates>> ...]" << std::endl;
+    std::cerr << "A configuration is gpu or cpu, then :-separated options among auto, projections, layered, image, dominant, slab32, slab64, slab128, tile<size> and sparse, e.g. gpu:projections:slab32." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    /* Argument parsing */
+    Voxelizer::Mode mode = Voxelizer::Mode::Surface;
+    std::string modeName = "surface";
+    std::vector<unsigned int> resolutions = {64, 128, 256};
+    double tolerance = 0.0;
+    bool superset = false;
+    std::vector<std::string> args;
+    for (int i = 1 ; i < argc ; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--mode" && i + 1 < argc) {
+            modeName = argv[++i];
+            if (!ToolHelpers::parseMode(modeName, mode)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--resolutions" && i + 1 < argc) {
+            resolutions.clear();
+            if (!ToolHelpers::parseResolutions(argv[++i], resolutions)) {
+                std::cerr << "Error: invalid resolution list \"" << argv[i] << "\"." << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            if (!(ss >> tolerance) || tolerance < 0.0) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--superset") {
+            superset = true;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            printUsage();
+            return EXIT_FAILURE;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    Config configs[2];
+    if (args.size() < 2 || resolutions.empty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    for (int iC = 0 ; iC < 2 ; ++iC) {
+        if (!parseConfig(args[iC], configs[iC])) {
+            std::cerr << "Error: invalid configuration \"" << args[iC] << "\"." << std::endl;
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    std::vector<std::string> meshes(args.begin() + 2, args.end());
+    if (meshes.empty())
+        meshes = {"rc/monkey.obj", "rc/human.obj", "sphere:6", "soup:100000", "plates:16"};
+
+    /* The CPU backend doesn't need any OpenGL context */
+    const bool useGPU = (configs[0].backend == Voxelizer::Backend::GPU || configs[1].backend == Voxelizer::Backend::GPU);
+    std::unique_ptr<HeadlessContext> context;
+    if (useGPU) {
+        context.reset(new HeadlessContext());
+        if (!context->isValid())
+            return EXIT_FAILURE;
+        std::cerr << "Using OpenGL: " << context->description() << std::endl;
+    }
+    std::unique_ptr<Voxelizer> voxelizers[2];
+    for (int iC = 0 ; iC < 2 ; ++iC) {
+        voxelizers[iC].reset(new Voxelizer(configs[iC].backend, configs[iC].gpuMethod));
+        voxelizers[iC]->setSlabWidth(configs[iC].slabWidth);
+    }
+
+    std::cout << "{\n";
+    std::cout << "  \"a\": \"" << configs[0].name << "\",\n";
+    std::cout << "  \"b\": \"" << configs[1].name << "\",\n";
+    std::cout << "  \"mode\": \"" << modeName << "\",\n";
+    std::cout << "  \"tolerance\": " << tolerance << ",\n";
+    std::cout << "  \"superset\": " << (superset ? "true" : "false") << ",\n";
+    std::cout << "  \"renderer\": \"" << (context ? context->description() : std::string("cpu")) << "\",\n";
+    std::cout << "  \"comparisons\": [";
+
+    bool success = true;
+    bool firstComparison = true;
+    for (std::string const& name : meshes) {
+        std::vector<glm::vec3> vertices, normals;
+        std::vector<glm::ivec3> triangles;
+        if (!ToolHelpers::loadMesh(name, vertices, normals, triangles))
+            return EXIT_FAILURE;
+        std::unique_ptr<MeshRenderable> mesh;
+        if (useGPU)
+            mesh.reset(new MeshRenderable(vertices, normals, triangles));
+
+        for (unsigned int resolution : resolutions) {
+            std::vector<uint32_t> grids[2];
+            glm::uvec3 nbVoxels[2];
+            for (int iC = 0 ; iC < 2 ; ++iC) {
+                MeshRenderable* configMesh = (configs[iC].backend == Voxelizer::Backend::GPU) ? mesh.get() : nullptr;
+                computeGrid(configs[iC], *voxelizers[iC], configMesh, vertices, triangles, resolution, mode, grids[iC]);
+                nbVoxels[iC] = voxelizers[iC]->getNbVoxels();
+            }
+
+            std::cout << (firstComparison ? "\n" : ",\n");
+            firstComparison = false;
+            std::cout << "    {\"mesh\": \"" << name << "\", \"resolution\": " << resolution
+                      << ", \"grid\": [" << nbVoxels[0].x << ", " << nbVoxels[0].y << ", " << nbVoxels[0].z << "]";
+            if (nbVoxels[0] != nbVoxels[1] || grids[0].size() != grids[1].size()) {
+                std::cout << ", \"error\": \"different grid dimensions\", \"pass\": false}";
+                success = false;
+                continue;
+            }
+
+            Difference added = {0, nbVoxels[0], glm::uvec3(0u)};
+            Difference removed = {0, nbVoxels[0], glm::uvec3(0u)};
+            for (std::size_t i = 0 ; i < grids[0].size() ; ++i) {
+                addWord(added, grids[1][i] & ~grids[0][i], i, nbVoxels[0]);
+                addWord(removed, grids[0][i] & ~grids[1][i], i, nbVoxels[0]);
+            }
+            const std::size_t nbVoxelsA = ToolHelpers::countVoxels(grids[0]);
+            const std::size_t hamming = added.nbVoxels + removed.nbVoxels;
+            const bool pass = ((superset ? removed.nbVoxels : hamming) <= tolerance * nbVoxelsA);
+            success = success && pass;
+
+            std::cout << ", \"voxelsA\": " << nbVoxelsA << ", \"voxelsB\": " << ToolHelpers::countVoxels(grids[1])
+                      << ", \"added\": " << added.nbVoxels << ", \"addedBox\": " << boxJson(added)
+                      << ", \"removed\": " << removed.nbVoxels << ", \"removedBox\": " << boxJson(removed)
+                      << ", \"hamming\": " << hamming << ", \"pass\": " << (pass ? "true" : "false") << "}";
+        }
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,363 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+
+#include "HeadlessContext.hpp"
+#include "MeshRenderable.hpp"
+#include "ToolHelpers.hpp"
+#include "Voxelizer.hpp"
+#include "VoxelizerBatch.hpp"
+#include "IO.hpp"
+
+
+/* Headless batch voxelization: no window, no event loop, no rendering.
+ * Diagnostics go to std::cerr, std::cout only receives the JSON report. */
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point const& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* Per-phase timings of a run, see Voxelizer::Stats */
+static std::string statsJson(Voxelizer::Stats const& stats)
+{
+    std::stringstream json;
+    json << "{\"gpu\": {\"xProjection\": " << stats.xProjection << ", \"yProjection\": " << stats.yProjection
+         << ", \"zProjection\": " << stats.zProjection << ", \"imageDraw\": " << stats.imageDraw
+         << ", \"compile\": " << stats.compile << ", \"readback\": " << stats.readback
+         << ", \"coverage\": " << stats.coverage << ", \"pyramid\": " << stats.pyramid << "}"
+         << ", \"cpu\": {\"submit\": " << stats.cpuSubmit << ", \"readback\": " << stats.cpuReadback
+         << ", \"total\": " << stats.cpuTotal << "}}";
+    return json.str();
+}
+
+static std::string jsonString(std::string const& s)
+{
+    std::string result = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result + "\"";
+}
+
+/* With several resolutions, "out.vox" becomes "out_64.vox", "out_128.vox"... */
+static std::string outputFilename(std::string const& output, unsigned int resolution, bool severalResolutions)
+{
+    if (!severalResolutions)
+        return output;
+
+    std::size_t slash = output.find_last_of("\\/");
+    std::size_t dot = output.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        dot = output.size();
+
+    std::stringstream ss;
+    ss << output.substr(0, dot) << "_" << resolution << output.substr(dot);
+    return ss.str();
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage: voxelize [--backend gpu|cpu] [--gpu-method auto|projections|layered|image|dominant] [--mode surface|conservative6|conservative26|solid] [--slab 32|64|128] [--tile <size>] [--sparse] [--region minX,minY,minZ,maxX,maxY,maxZ] [--coverage 4|8] [--attributes] [--jobs <number in flight>] <path to obj file> <resolution[,resolution...]> <output file>" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    /* Argument parsing */
+    Voxelizer::Backend backend = Voxelizer::Backend::GPU;
+    Voxelizer::GPUMethod gpuMethod = Voxelizer::GPUMethod::Auto;
+    Voxelizer::Mode mode = Voxelizer::Mode::Surface;
+    std::string modeName = "surface";
+    unsigned int tileSize = 0;
+    unsigned int slabWidth = 0; //automatic
+    bool hasRegion = false;
+    Voxelizer::Coverage coverage = Voxelizer::Coverage::None;
+    bool withAttributes = false;
+    bool sparse = false;
+    unsigned int nbJobs = 1;
+    glm::vec3 regionMin, regionMax;
+    std::vector<std::string> args;
+    for (int i = 1 ; i < argc ; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--backend" && i + 1 < argc) {
+            if (!ToolHelpers::parseBackend(argv[++i], backend)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--gpu-method" && i + 1 < argc) {
+            if (!ToolHelpers::parseGPUMethod(argv[++i], gpuMethod)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--mode" && i + 1 < argc) {
+            modeName = argv[++i];
+            if (!ToolHelpers::parseMode(modeName, mode)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--tile" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            int value = 0;
+            if (!(ss >> value) || value < 32 || value % 32 != 0) {
+                std::cerr << "Error: the tile size must be a multiple of 32." << std::endl;
+                return EXIT_FAILURE;
+            }
+            tileSize = value;
+        } else if (arg == "--slab" && i + 1 < argc) {
+            const std::string value(argv[++i]);
+            if (value != "32" && value != "64" && value != "128") {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+            slabWidth = std::stoi(value);
+        } else if (arg == "--coverage" && i + 1 < argc) {
+            const std::string value(argv[++i]);
+            if (value == "4") {
+                coverage = Voxelizer::Coverage::Bits4;
+            } else if (value == "8") {
+                coverage = Voxelizer::Coverage::Bits8;
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            int value = 0;
+            if (!(ss >> value) || value < 1) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+            nbJobs = value;
+        } else if (arg == "--attributes") {
+            withAttributes = true;
+        } else if (arg == "--sparse") {
+            sparse = true;
+        } else if (arg == "--region" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            float bounds[6];
+            char comma = ',';
+            for (unsigned int iB = 0 ; iB < 6 && ss && comma == ',' ; ++iB) {
+                ss >> bounds[iB];
+                if (iB < 5)
+                    ss >> comma;
+            }
+            if (!ss || comma != ',') {
+                std::cerr << "Error: invalid region \"" << argv[i] << "\"." << std::endl;
+                return EXIT_FAILURE;
+            }
+            hasRegion = true;
+            regionMin = glm::vec3(bounds[0], bounds[1], bounds[2]);
+            regionMax = glm::vec3(bounds[3], bounds[4], bounds[5]);
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.size() != 3) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    if (withAttributes && tileSize > 0) {
+        std::cerr << "Error: --attributes needs the whole grid in memory and can't be used with --tile." << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (sparse && (tileSize > 0 || withAttributes || mode == Voxelizer::Mode::Solid)) {
+        std::cerr << "Error: --sparse can't be used with --tile, --attributes or the solid mode." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string filename(args[0]);
+    const std::string output(args[2]);
+    std::vector<unsigned int> resolutions;
+    if (!ToolHelpers::parseResolutions(args[1], resolutions)) {
+        std::cerr << "Error: invalid resolution list \"" << args[1] << "\"." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    /* The CPU backend doesn't need any OpenGL context */
+    Clock::time_point start = Clock::now();
+    std::unique_ptr<HeadlessContext> context;
+    if (backend == Voxelizer::Backend::GPU) {
+        context.reset(new HeadlessContext());
+        if (!context->isValid())
+            return EXIT_FAILURE;
+        std::cerr << "Using OpenGL: " << context->description() << std::endl;
+    }
+    const double contextTime = elapsedMs(start);
+
+    start = Clock::now();
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::ivec3> triangles;
+    std::vector<int> triangleMaterials;
+    std::vector<IO::Material> materials;
+    const bool loaded = withAttributes ? IO::readObj(filename, vertices, triangles, triangleMaterials, materials)
+                                       : IO::readObj(filename, vertices, normals, triangles);
+    if (!loaded || triangles.empty()) {
+        std::cerr << "Error: no triangle loaded from " << filename << "." << std::endl;
+        return EXIT_FAILURE;
+    }
+    const double loadTime = elapsedMs(start);
+
+    start = Clock::now();
+    std::unique_ptr<MeshRenderable> mesh;
+    if (backend == Voxelizer::Backend::GPU)
+        mesh.reset(new MeshRenderable(vertices, normals, triangles));
+    const double uploadTime = elapsedMs(start);
+
+    /* On the GPU, the resolutions are computed as a batch: the next ones are in flight while a grid is written.
+     * Tiles and sparse grids are computed one after the other */
+    const bool batched = (mesh && tileSize == 0 && !sparse);
+    start = Clock::now();
+    VoxelizerBatch batch(batched ? nbJobs : 1, backend, gpuMethod);
+    for (unsigned int i = 0 ; i < batch.nbInFlight() ; ++i) {
+        Voxelizer& voxelizer = batch.voxelizer(i);
+        if (hasRegion)
+            voxelizer.setRegion(regionMin, regionMax);
+        voxelizer.setCoverage(coverage);
+        voxelizer.setSlabWidth(slabWidth);
+    }
+    Voxelizer& voxelizer = batch.voxelizer(0);
+    const double initTime = elapsedMs(start);
+
+    bool success = true;
+    std::stringstream runs;
+    double voxelizeTime = 0.0, writeTime = 0.0;
+    std::size_t nbSetVoxels = 0;
+    SparseGrid sparseGrid;
+    auto addRun = [&](std::size_t iR, Voxelizer const& result) {
+        const glm::uvec3 nbVoxels = result.getNbVoxels();
+        runs << (iR == 0 ? "\n" : ",\n");
+        runs << "    {\"resolution\": " << resolutions[iR]
+             << ", \"grid\": [" << nbVoxels.x << ", " << nbVoxels.y << ", " << nbVoxels.z << "]"
+             << ", \"voxels\": " << nbSetVoxels;
+        if (sparse)
+            runs << ", \"bricks\": " << sparseGrid.getNbBricks() << ", \"bytes\": " << sparseGrid.getMemorySize();
+        runs << ", \"output\": " << jsonString(outputFilename(output, resolutions[iR], resolutions.size() > 1))
+             << ", \"timings\": {\"voxelize\": " << voxelizeTime << ", \"write\": " << writeTime << "}"
+             << ", \"stats\": " << statsJson(result.lastStats()) << "}";
+    };
+
+    /* Grid and its side files */
+    auto writeResult = [&](std::size_t iR, Voxelizer const& result) {
+        const std::string outputFile = outputFilename(output, resolutions[iR], resolutions.size() > 1);
+        const glm::uvec3 nbVoxels = result.getNbVoxels();
+        if (result.grid().size() != (std::size_t)nbVoxels.x * nbVoxels.y * nbVoxels.z / 32) {
+            nbSetVoxels = 0;
+            success = false; //the Voxelizer already told why
+            return;
+        }
+        success = IO::writeVoxels(outputFile, result.getNbVoxels(), result.getMinCorner(), result.getVoxelSize(), result.grid()) && success;
+        nbSetVoxels = ToolHelpers::countVoxels(result.grid());
+        if (!result.coverageGrid().empty()) {
+            success = IO::writeCoverage(outputFile + ".cov", result.getNbVoxels(), result.getMinCorner(), result.getVoxelSize(),
+                                        (coverage == Voxelizer::Coverage::Bits4) ? 4 : 8, result.coverageGrid()) && success;
+        }
+        if (withAttributes) {
+            VoxelAttributes attributes;
+            attributes.compute(result.grid(), result.getNbVoxels(), result.getMinCorner(), result.getVoxelSize(),
+                               vertices, triangles, triangleMaterials);
+            success = IO::writeAttributes(outputFile + ".attr", attributes, materials) && success;
+        }
+    };
+
+    VoxelizerBatch::Stats stats = {0, 0, 0.0};
+    if (batched) {
+        /* The voxelize timing of a run is the wait for its result, after the previous one was written */
+        std::vector<VoxelizerBatch::Job> jobs;
+        for (unsigned int resolution : resolutions)
+            jobs.push_back(VoxelizerBatch::Job{mesh.get(), resolution, mode});
+
+        start = Clock::now();
+        stats = batch.run(jobs, [&](std::size_t iR, Voxelizer const& result) {
+            voxelizeTime = elapsedMs(start);
+            start = Clock::now();
+            writeResult(iR, result);
+            writeTime = elapsedMs(start);
+            addRun(iR, result);
+            start = Clock::now();
+        });
+    }
+
+    for (std::size_t iR = 0 ; iR < resolutions.size() && !batched ; ++iR) {
+        const unsigned int resolution = resolutions[iR];
+        const std::string outputFile = outputFilename(output, resolution, resolutions.size() > 1);
+
+        voxelizeTime = 0.0;
+        writeTime = 0.0;
+        nbSetVoxels = 0;
+        const Clock::time_point runStart = Clock::now();
+        start = runStart;
+        if (tileSize > 0) {
+            /* Tiles are streamed to the file as they come, the whole grid is never in memory */
+            Voxelizer::TileCallback writeTile = [&](glm::uvec3 const& tileOrigin, glm::uvec3 const& tileNbVoxels,
+                                                    std::vector<uint32_t> const& tile) {
+                voxelizeTime += elapsedMs(start);
+                start = Clock::now();
+                if (tileOrigin == glm::uvec3(0u))
+                    success = IO::createVoxelsFile(outputFile, voxelizer.getNbVoxels(), voxelizer.getMinCorner(), voxelizer.getVoxelSize()) && success;
+                success = IO::writeVoxelsTile(outputFile, voxelizer.getNbVoxels(), tileOrigin, tileNbVoxels, tile) && success;
+                nbSetVoxels += ToolHelpers::countVoxels(tile);
+                writeTime += elapsedMs(start);
+                start = Clock::now();
+            };
+            if (mesh)
+                voxelizer.recomputeTiled(*mesh, resolution, tileSize, writeTile, mode);
+            else
+                voxelizer.recomputeTiled(vertices, triangles, resolution, tileSize, writeTile, mode);
+        } else if (sparse) {
+            /* Only the bricks the surface goes through are computed and written */
+            if (mesh)
+                voxelizer.recomputeSparse(*mesh, resolution, sparseGrid, mode);
+            else
+                voxelizer.recomputeSparse(vertices, triangles, resolution, sparseGrid, mode);
+            voxelizeTime = elapsedMs(start);
+
+            start = Clock::now();
+            success = IO::writeSparseVoxels(outputFile, sparseGrid) && success;
+            for (std::size_t iB = 0 ; iB < sparseGrid.getNbBricks() ; ++iB)
+                nbSetVoxels += ToolHelpers::countVoxels(sparseGrid.brickWords(iB), SparseGrid::BRICK_WORDS);
+            writeTime = elapsedMs(start);
+        } else {
+            voxelizer.recompute(vertices, triangles, resolution, mode);
+            voxelizeTime = elapsedMs(start);
+
+            start = Clock::now();
+            writeResult(iR, voxelizer);
+            writeTime = elapsedMs(start);
+        }
+        addRun(iR, voxelizer);
+
+        const glm::uvec3 nbVoxels = voxelizer.getNbVoxels();
+        stats.nbMeshes += 1;
+        stats.nbVoxels += (std::size_t)nbVoxels.x * nbVoxels.y * nbVoxels.z;
+        stats.seconds += elapsedMs(runStart) / 1000.0;
+    }
+
+    std::cout << "{\n";
+    std::cout << "  \"mesh\": " << jsonString(filename) << ",\n";
+    std::cout << "  \"vertices\": " << vertices.size() << ",\n";
+    std::cout << "  \"triangles\": " << triangles.size() << ",\n";
+    std::cout << "  \"backend\": " << (backend == Voxelizer::Backend::GPU ? "\"gpu\"" : "\"cpu\"") << ",\n";
+    if (backend == Voxelizer::Backend::GPU)
+        std::cout << "  \"gpuMethod\": " << jsonString(ToolHelpers::gpuMethodName(voxelizer.gpuMethod())) << ",\n";
+    std::cout << "  \"mode\": " << jsonString(modeName) << ",\n";
+    if (tileSize > 0)
+        std::cout << "  \"tile\": " << tileSize << ",\n";
+    if (sparse)
+        std::cout << "  \"sparse\": true,\n";
+    std::cout << "  \"jobs\": " << batch.nbInFlight() << ",\n";
+    std::cout << "  \"renderer\": " << jsonString(context ? context->description() : std::string("cpu")) << ",\n";
+    std::cout << "  \"timings\": {\"context\": " << contextTime << ", \"load\": " << loadTime
+              << ", \"upload\": " << uploadTime << ", \"init\": " << initTime << "},\n";
+    std::cout << "  \"throughput\": {\"meshes\": " << stats.meshesPerSecond() << ", \"voxels\": " << stats.voxelsPerSecond() << "},\n";
+    std::cout << "  \"runs\": [" << runs.str() << "\n  ]\n";
+    std::cout << "}" << std::endl;
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}